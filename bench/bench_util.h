@@ -0,0 +1,41 @@
+// Helpers shared by the benchmarks. Include after homestead.cpp.
+#ifndef HOMESTEAD_BENCH_UTIL_H
+#define HOMESTEAD_BENCH_UTIL_H
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+
+// Average wall time of one call to body, in milliseconds
+template<typename Body>
+static double timeMs(int repeats, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < repeats; r++) {
+        body();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count() / repeats;
+}
+
+template<typename Body>
+static double timeMs(Body body) {
+    return timeMs(1, body);
+}
+
+// A fixed-seed colony of count colonists with mixed specializations, health
+// 30..100 and roughly one in ten already assigned
+static ColonistPool makePool(std::size_t count) {
+    std::mt19937 generator(12345);
+    std::uniform_int_distribution<int> specRoll(0, static_cast<int>(kSpecializationCount) - 1);
+    std::uniform_int_distribution<int> healthRoll(30, 100);
+    std::uniform_int_distribution<int> assignRoll(0, 9);
+
+    ColonistPool pool;
+    for(std::size_t i = 0; i < count; i++) {
+        pool.add("Colonist", static_cast<Specialization>(specRoll(generator)), 0,
+                 healthRoll(generator), assignRoll(generator) == 0);
+    }
+    return pool;
+}
+
+#endif
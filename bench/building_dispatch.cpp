@@ -0,0 +1,167 @@
+// Benchmark of building storage layouts for the production pass:
+//   virtual   - std::vector<std::unique_ptr<Building>>, virtual produce()
+//   variant   - VariantBuildingList, std::visit over buildings stored by value
+//   soa       - BuildingStore::totalProduction(), the engine's layout
+// Each layout is built from the same seeded mix of types, levels and
+// operational flags and must produce the same totals. They must also agree,
+// with each other and with the store's running total, for buildings at the
+// top level, whose output does not fit 32 bits, and all refuse a further
+// upgrade. Build with
+// -DHOMESTEAD_RESOURCE_POLICY=SaturatingInt32Policy to check that they all
+// clamp the same way.
+//
+// Build: g++ -std=c++17 -O2 -o building_dispatch bench/building_dispatch.cpp
+// Run:   ./building_dispatch [count ...]   (default: 1000 100000 10000000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+
+#include <cstdlib>
+
+struct BuildingSpec {
+    BuildingType type;
+    int upgrades;
+    bool operational;
+};
+
+static std::vector<BuildingSpec> makeSpecs(std::size_t count) {
+    std::mt19937 generator(12345);
+    std::uniform_int_distribution<int> typeRoll(0, static_cast<int>(kBuildingTypeCount) - 1);
+    std::uniform_int_distribution<int> upgradeRoll(0, 4);
+    std::uniform_int_distribution<int> offlineRoll(0, 9);
+
+    std::vector<BuildingSpec> specs(count);
+    for(BuildingSpec& spec : specs) {
+        spec.type = static_cast<BuildingType>(typeRoll(generator));
+        spec.upgrades = upgradeRoll(generator);
+        spec.operational = offlineRoll(generator) != 0;
+    }
+    return specs;
+}
+
+static std::unique_ptr<Building> makeVirtualBuilding(BuildingType type) {
+    switch(type) {
+        case BuildingType::SolarPanel: return std::make_unique<SolarPanel>();
+        case BuildingType::Greenhouse: return std::make_unique<Greenhouse>();
+        case BuildingType::OxygenGenerator: return std::make_unique<OxygenGenerator>();
+        default: return std::make_unique<MaterialFactory>();
+    }
+}
+
+// Runs pass() enough times to cover roughly 20M building visits and
+// reports the time per building
+template<typename Pass>
+static Resource timePasses(const char* label, std::size_t count, Pass pass) {
+    std::size_t repeats = std::max<std::size_t>(1, 20000000 / count);
+    Resource total;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t r = 0; r < repeats; r++) {
+        total = pass();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double nsPerBuilding = std::chrono::duration<double, std::nano>(elapsed).count() / (repeats * count);
+    std::cout << "  " << label << ": " << nsPerBuilding << " ns/building" << std::endl;
+    return total;
+}
+
+static void runCount(std::size_t count) {
+    std::cout << count << " buildings" << std::endl;
+    std::vector<BuildingSpec> specs = makeSpecs(count);
+
+    Resource virtualTotal;
+    {
+        std::vector<std::unique_ptr<Building>> buildings;
+        buildings.reserve(count);
+        for(const BuildingSpec& spec : specs) {
+            buildings.push_back(makeVirtualBuilding(spec.type));
+            for(int u = 0; u < spec.upgrades; u++) buildings.back()->upgrade();
+            buildings.back()->setOperational(spec.operational);
+        }
+        virtualTotal = timePasses("virtual", count, [&] {
+            Resource total;
+            for(auto& building : buildings) {
+                total += building->produce();
+            }
+            return total;
+        });
+    }
+
+    Resource variantTotal;
+    {
+        VariantBuildingList buildings;
+        buildings.reserve(count);
+        for(std::size_t i = 0; i < count; i++) {
+            buildings.add(specs[i].type);
+            for(int u = 0; u < specs[i].upgrades; u++) buildings[i].upgrade();
+            buildings[i].setOperational(specs[i].operational);
+        }
+        variantTotal = timePasses("variant", count, [&] { return buildings.totalProduction(); });
+    }
+
+    Resource storeTotal;
+    {
+        BuildingStore buildings;
+        for(const BuildingSpec& spec : specs) {
+            buildings.add(spec.type, 1 + spec.upgrades, spec.operational);
+        }
+        storeTotal = timePasses("soa", count, [&] { return buildings.totalProduction(); });
+    }
+
+    if(virtualTotal != variantTotal || virtualTotal != storeTotal) {
+        std::cout << "FAIL: layouts disagree on total production" << std::endl;
+        std::exit(1);
+    }
+}
+
+static void checkHighLevels() {
+    const int level = kMaxBuildingLevel;
+    std::vector<std::unique_ptr<Building>> buildings;
+    VariantBuildingList variants;
+    BuildingStore store;
+    Resource virtualTotal;
+    for(std::size_t t = 0; t < kBuildingTypeCount; t++) {
+        for(int copy = 0; copy < 3; copy++) {
+            BuildingType type = static_cast<BuildingType>(t);
+            buildings.push_back(makeVirtualBuilding(type));
+            variants.add(type);
+            for(int u = 1; u < level; u++) {
+                buildings.back()->upgrade();
+                variants[variants.size() - 1].upgrade();
+            }
+            store.add(type, level);
+            virtualTotal += buildings.back()->produce();
+        }
+    }
+
+    bool agree = virtualTotal == variants.totalProduction() && virtualTotal == store.totalProduction() &&
+                 virtualTotal == store.getProduction();
+    std::cout << "level " << level << " buildings: layouts " << (agree ? "agree" : "disagree") << std::endl;
+    if(!agree) {
+        std::cout << "FAIL: layouts disagree on high-level production" << std::endl;
+        std::exit(1);
+    }
+
+    // One more upgrade is refused everywhere instead of wrapping the level
+    bool capped = !buildings.back()->upgrade() && !variants[variants.size() - 1].upgrade() && !store.upgrade(0) &&
+                  buildings.back()->getLevel() == level && store.getLevel(0) == level &&
+                  store.getProduction() == store.totalProduction() && store.getProduction() == virtualTotal;
+    if(!capped) {
+        std::cout << "FAIL: upgrading past level " << level << " was not refused" << std::endl;
+        std::exit(1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::size_t> counts = { 1000, 100000, 10000000 };
+    if(argc > 1) {
+        counts.clear();
+        for(int i = 1; i < argc; i++) {
+            counts.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+
+    checkHighLevels();
+    for(std::size_t count : counts) {
+        runCount(count);
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+// Benchmark of the colonist work step on a large ColonistPool: eligibility
+// masks, the cached work kernel, bulk restAll() and a mass-casualty turn
+// (damageAll() then removeDead()).
+//
+// Build: g++ -std=c++17 -O3 -o colonist_pool bench/colonist_pool.cpp
+// Run:   ./colonist_pool [count]   (default: 10000000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+#include "bench_util.h"
+
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+    ColonistPool pool = makePool(count);
+
+    const int repeats = 20;
+    std::size_t eligible = 0;
+    Resource output;
+    double eligibleMs = timeMs(repeats, [&] { eligible = pool.updateEligible(); });
+    double workMs = timeMs(repeats, [&] { output = pool.workEligible(); });
+    // Starting health is 30..100, so this kills everyone at 60 or below
+    double damageMs = timeMs(1, [&] { pool.damageAll(60); });
+    std::size_t deaths = 0;
+    double removeMs = timeMs(1, [&] { deaths = pool.removeDead([](const std::string&) {}); });
+    double restMs = timeMs(repeats, [&] { pool.restAll(); });
+
+    std::cout << count << " colonists, " << eligible << " eligible" << std::endl;
+    std::cout << "  eligibility mask: " << eligibleMs << " ms" << std::endl;
+    std::cout << "  work step:        " << workMs << " ms" << std::endl;
+    std::cout << "  production turn:  " << eligibleMs + workMs << " ms" << std::endl;
+    std::cout << "  damage all:       " << damageMs << " ms" << std::endl;
+    std::cout << "  remove " << deaths << " dead: " << removeMs << " ms" << std::endl;
+    std::cout << "  rest all:         " << restMs << " ms" << std::endl;
+    std::cout << "  (checksum " << output[ResourceType::Food] << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Determinism check and scaling benchmark for the threaded colonist work
+// step. Runs the same turns on identical pools with 1..N threads, compares
+// per-turn output and the final pool state hash against the serial run, and
+// exits 1 on any mismatch.
+//
+// Build: g++ -std=c++17 -O3 -pthread -o colonist_threads bench/colonist_threads.cpp
+// Run:   ./colonist_threads [count] [max threads]   (default: 10000000, hardware threads)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+#include "bench_util.h"
+
+#include <cstdlib>
+
+struct RunResult {
+    std::uint64_t outputHash;
+    std::uint64_t stateHash;
+    double workMs;
+};
+
+// Plays a few turns: work, then reassign a deterministic slice and rest
+static RunResult run(std::size_t count, std::size_t threads, int turns) {
+    ColonistPool pool = makePool(count);
+    WorkerPool workers(threads);
+    StateHasher outputs;
+    double workMs = 0;
+    for(int turn = 0; turn < turns; turn++) {
+        pool.updateEligible();
+        auto start = std::chrono::steady_clock::now();
+        Resource output = pool.workEligible(&workers);
+        workMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        outputs.add(output);
+        for(std::size_t i = static_cast<std::size_t>(turn); i < count; i += 7) {
+            pool.setAssigned(i, true);
+        }
+        if(turn % 2 == 1) {
+            pool.restAll();
+        }
+    }
+    StateHasher state;
+    pool.hashState(state);
+    return { outputs.value(), state.value(), workMs / turns };
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    std::size_t maxThreads = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                      : std::max(2u, std::thread::hardware_concurrency());
+    const int turns = 6;
+
+    RunResult serial = run(count, 1, turns);
+    std::cout << count << " colonists, " << turns << " turns" << std::endl;
+    std::cout << "  1 thread:  " << serial.workMs << " ms/turn, state " << std::hex << serial.stateHash
+              << std::dec << std::endl;
+
+    bool identical = true;
+    for(std::size_t threads = 2; threads <= maxThreads; threads *= 2) {
+        RunResult parallel = run(count, threads, turns);
+        bool same = parallel.outputHash == serial.outputHash && parallel.stateHash == serial.stateHash;
+        identical = identical && same;
+        std::cout << "  " << threads << " threads: " << parallel.workMs << " ms/turn, state " << std::hex
+                  << parallel.stateHash << std::dec << (same ? "" : "  MISMATCH") << std::endl;
+    }
+    return identical ? 0 : 1;
+}
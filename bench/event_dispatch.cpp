@@ -0,0 +1,134 @@
+// Benchmark of the event bytecode interpreter: nanoseconds per execution of
+// each built-in event and of a colonist-loop script, with console output
+// discarded, plus a Solar Storm in a large colony whose only engineer joined
+// last (a role lookup that used to scan the whole roster). Build once more
+// with -DHOMESTEAD_SWITCH_DISPATCH to compare threaded dispatch against a
+// plain switch.
+//
+// Before timing, it checks that event stock changes follow the resource
+// policy and exits 1 if they do not. Build with
+// -DHOMESTEAD_RESOURCE_POLICY=SaturatingInt32Policy to check that a gain
+// clamps at the top of a 32-bit lane.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o event_dispatch bench/event_dispatch.cpp
+// Run:   ./event_dispatch [runs] [large colony]   (default: 1000000 200000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+
+#include <cstdlib>
+
+const char* const kLoopScript = R"(
+event Census
+chance 1
+text Counting heads.
+each Farmer fit
+    add food 1
+end
+each sick
+    if oxygen > 10
+        add oxygen -1
+    end
+end
+)";
+
+const char* const kLimitScript = R"(
+event Windfall
+chance 0
+text Energy to spare, food to lose.
+add energy 100
+add food -50
+)";
+
+// A gain on a stock near INT32_MAX goes through the policy, and a loss
+// larger than the stock stops at zero and reports the shortfall
+static bool stockLimitsHold(EventCompiler& compiler) {
+    std::istringstream script(kLimitScript);
+    std::unique_ptr<Event> event = std::move(compiler.compile(script, "limit script").front());
+    ColonistPool colonists;
+    Resource resources;
+    const Resource::Quantity nearTop = INT32_MAX - 10;
+    resources[ResourceType::Energy] = nearTop;
+    resources[ResourceType::Food] = 30;
+    std::ostringstream messages;
+    event->execute(resources, colonists, nullptr, messages);
+
+    bool ok = resources[ResourceType::Energy] == Resource::ArithmeticPolicy::add(nearTop, 100) &&
+              resources[ResourceType::Food] == 0 &&
+              messages.str().find("short by 20") != std::string::npos;
+    if constexpr(std::is_same<Resource::ArithmeticPolicy, SaturatingInt32Policy>::value) {
+        ok = ok && resources[ResourceType::Energy] == INT32_MAX;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t runs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t largeColony = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+
+    EventCompiler compiler;
+    std::istringstream builtins(kDefaultEventScript);
+    std::vector<std::unique_ptr<Event>> events = compiler.compile(builtins, "built-in events");
+    std::istringstream loop(kLoopScript);
+    events.push_back(std::move(compiler.compile(loop, "loop script").front()));
+
+    bool limits = stockLimitsHold(compiler);
+    std::cout << "stock limits: " << (limits ? "ok" : "MISMATCH") << std::endl;
+    if(!limits) {
+        return 1;
+    }
+
+    ColonistPool colonists;
+    colonists.add("Alex Chen", Specialization::Engineer);
+    colonists.add("Maria Santos", Specialization::Scientist);
+    colonists.add("James Wilson", Specialization::Farmer);
+    colonists.add("Ana Ruiz", Specialization::Farmer, 0, 40);
+    Resource stock = Resource::startingStock();
+
+#if defined(__GNUC__) && !defined(HOMESTEAD_SWITCH_DISPATCH)
+    const char* dispatch = "threaded";
+#else
+    const char* dispatch = "switch";
+#endif
+    std::cout << runs << " runs per event, " << dispatch << " dispatch, " << colonists.size() << " colonists"
+              << std::endl;
+
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+    std::vector<double> nanoseconds;
+    for(const auto& event : events) {
+        Resource resources = stock;
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t r = 0; r < runs; r++) {
+            event->execute(resources, colonists);
+            resources = stock;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        nanoseconds.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / runs);
+    }
+
+    ColonistPool large;
+    for(std::size_t i = 0; i + 1 < largeColony; i++) {
+        large.add("Farmer", Specialization::Farmer);
+    }
+    large.add("Engineer", Specialization::Engineer);
+    double largeNs;
+    {
+        Resource resources = stock;
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t r = 0; r < runs; r++) {
+            events[0]->execute(resources, large);
+            resources = stock;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        largeNs = std::chrono::duration<double, std::nano>(elapsed).count() / runs;
+    }
+    std::cout.rdbuf(console);
+    std::cout.clear();
+
+    for(std::size_t i = 0; i < events.size(); i++) {
+        std::cout << "  " << events[i]->getName() << " (" << events[i]->getProgram().instructions().size()
+                  << " instructions): " << nanoseconds[i] << " ns" << std::endl;
+    }
+    std::cout << "  " << events[0]->getName() << " with " << large.size() << " colonists: " << largeNs << " ns"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Benchmark of event selection with 10k registered events: the engine's
+// alias table against a linear walk over cumulative weights. Also checks
+// that alias draws match the weights and exits 1 if they drift.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o event_selection bench/event_selection.cpp
+// Run:   ./event_selection [events] [draws]   (default: 10000 10000000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+#include "bench_util.h"
+
+#include <cmath>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    std::size_t eventCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    std::size_t draws = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+
+    std::mt19937 generator(12345);
+    std::uniform_int_distribution<std::uint64_t> weightRoll(1, 100);
+    std::vector<std::uint64_t> weights(eventCount);
+    std::uint64_t total = 0;
+    for(std::uint64_t& weight : weights) {
+        weight = weightRoll(generator);
+        total += weight;
+    }
+
+    AliasTable table;
+    double buildMs = timeMs([&] { table.build(weights); });
+
+    std::vector<std::size_t> counts(eventCount, 0);
+    double aliasMs = timeMs([&] {
+        for(std::size_t d = 0; d < draws; d++) {
+            counts[table.sample(generator)]++;
+        }
+    });
+
+    // Linear walk over the cumulative weights, as the old event loop did
+    std::size_t linearSum = 0;
+    double linearMs = timeMs([&] {
+        std::uniform_int_distribution<std::uint64_t> roll(0, total - 1);
+        for(std::size_t d = 0; d < draws; d++) {
+            std::uint64_t r = roll(generator);
+            std::size_t i = 0;
+            while(r >= weights[i]) {
+                r -= weights[i++];
+            }
+            linearSum += i;
+        }
+    });
+
+    // Chi-square statistic against the weights; for k - 1 degrees of freedom
+    // it should land near k, so allow a generous margin
+    double chiSquare = 0;
+    for(std::size_t i = 0; i < eventCount; i++) {
+        double expected = static_cast<double>(draws) * weights[i] / total;
+        chiSquare += (counts[i] - expected) * (counts[i] - expected) / expected;
+    }
+    double limit = eventCount + 6 * std::sqrt(2.0 * eventCount);
+    bool matches = chiSquare < limit;
+
+    std::cout << eventCount << " events, " << draws << " draws" << std::endl;
+    std::cout << "  alias build:  " << buildMs << " ms" << std::endl;
+    std::cout << "  alias draws:  " << aliasMs * 1e6 / draws << " ns/draw" << std::endl;
+    std::cout << "  linear walk:  " << linearMs * 1e6 / draws << " ns/draw (checksum " << linearSum << ")" << std::endl;
+    std::cout << "  chi-square:   " << chiSquare << " (limit " << limit << ")" << (matches ? "" : "  MISMATCH") << std::endl;
+    return matches ? 0 : 1;
+}
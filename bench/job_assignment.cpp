@@ -0,0 +1,50 @@
+// Benchmark of the JobAssigner: a full solve of a large colony against many
+// building jobs, then incremental re-solves after a few colonists change.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o job_assignment bench/job_assignment.cpp
+// Run:   ./job_assignment [colonists] [jobs]   (default: 100000 10000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+#include "bench_util.h"
+
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    std::size_t colonists = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    std::size_t jobs = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000;
+
+    std::mt19937 generator(12345);
+    std::uniform_int_distribution<int> specRoll(0, static_cast<int>(kSpecializationCount) - 1);
+    std::uniform_int_distribution<int> experienceRoll(0, 200);
+    std::uniform_int_distribution<std::size_t> pick(0, colonists - 1);
+
+    JobAssigner assigner;
+    for(std::size_t t = 0; t < kBuildingTypeCount; t++) {
+        assigner.setJobCount(static_cast<BuildingType>(t), jobs / kBuildingTypeCount);
+    }
+    double buildMs = timeMs([&] {
+        for(std::size_t i = 0; i < colonists; i++) {
+            assigner.addColonist(static_cast<Specialization>(specRoll(generator)), experienceRoll(generator));
+        }
+    });
+    std::int64_t yield = 0;
+    double solveMs = timeMs([&] { yield = assigner.solve(); });
+
+    std::cout << colonists << " colonists, " << jobs << " jobs" << std::endl;
+    std::cout << "  build:       " << buildMs << " ms" << std::endl;
+    std::cout << "  full solve:  " << solveMs << " ms (yield " << yield << ")" << std::endl;
+
+    const int rounds = 100;
+    const int changed = 10;
+    double resolveMs = timeMs([&] {
+        for(int r = 0; r < rounds; r++) {
+            for(int c = 0; c < changed; c++) {
+                assigner.updateColonist(pick(generator), static_cast<Specialization>(specRoll(generator)),
+                                        experienceRoll(generator));
+            }
+            yield = assigner.solve();
+        }
+    }) / rounds;
+    std::cout << "  re-solve after " << changed << " changes: " << resolveMs << " ms (yield " << yield << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Micro-benchmark for Resource accumulation.
+// Counts global heap allocations made while accumulating production the way
+// handleProductionPhase does, and exits non-zero if any are made.
+//
+// Build: g++ -std=c++17 -O2 -o resource_accumulate bench/resource_accumulate.cpp
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::size_t allocationCount = 0;
+
+// Every replaceable allocation form is counted and served from malloc or
+// aligned_alloc, so the matching deallocation forms can all use free
+static void* countedAllocate(std::size_t size, std::size_t alignment) {
+    allocationCount++;
+    if(size == 0) {
+        size = 1;
+    }
+    void* block = alignment <= alignof(std::max_align_t)
+                      ? std::malloc(size)
+                      : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if(block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size, 0); }
+void* operator new[](std::size_t size) { return countedAllocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept { std::free(block); }
+void operator delete(void* block, std::align_val_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept { std::free(block); }
+
+template<typename Body>
+static void runCase(const char* label, int iterations, Body body) {
+    Resource total;
+    std::size_t before = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; i++) {
+        body(total, i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::size_t allocations = allocationCount - before;
+
+    double nsPerIteration = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::cout << label << ": " << nsPerIteration << " ns/iter, "
+              << allocations << " allocations (checksum " << total[ResourceType::Food] << ")" << std::endl;
+    if(allocations != 0) {
+        std::cout << "FAIL: " << label << " allocated on the heap" << std::endl;
+        std::exit(1);
+    }
+}
+
+int main() {
+    const int iterations = 10000000;
+
+    // The registry allocates its name table once; keep that out of the counts
+    ResourceRegistry::instance();
+
+    Resource a, b, c, upkeep;
+    a[ResourceType::Energy] = 15;
+    b[ResourceType::Food] = 20;
+    c[ResourceType::Materials] = 5;
+    upkeep[ResourceType::Energy] = 5;
+
+    runCase("total += a", iterations, [&](Resource& total, int i) {
+        a[ResourceType::Food] = i & 7;
+        total += a;
+    });
+
+    runCase("total += a; total += b; total += c", iterations, [&](Resource& total, int i) {
+        a[ResourceType::Food] = i & 7;
+        total += a;
+        total += b;
+        total += c;
+    });
+
+    runCase("total += a + b + c", iterations, [&](Resource& total, int i) {
+        a[ResourceType::Food] = i & 7;
+        total += a + b + c;
+    });
+
+    runCase("total += a + b - upkeep", iterations, [&](Resource& total, int i) {
+        a[ResourceType::Food] = i & 7;
+        total += a + b - upkeep;
+    });
+
+    runCase("total = total + a + b", iterations, [&](Resource& total, int i) {
+        a[ResourceType::Food] = i & 7;
+        total = total + a + b;
+    });
+
+    std::cout << "OK: no heap allocations during accumulation" << std::endl;
+    return 0;
+}
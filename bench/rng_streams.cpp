@@ -0,0 +1,92 @@
+// Random stream check and benchmark. Verifies Philox4x32-10 and xoshiro256++
+// against published answers, recomputes event rolls for many (colony, turn)
+// keys on several threads in scrambled order and compares them with a serial
+// pass, then times a draw from each generator. Exits 1 on any mismatch.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o rng_streams bench/rng_streams.cpp
+// Run:   ./rng_streams [colonies] [turns] [draws]   (default: 1000 1000 100000000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+
+#include <cstdlib>
+
+template<typename Generator>
+static double nsPerDraw(Generator generator, std::uint64_t draws, std::uint64_t& sink) {
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t x = 0;
+    for(std::uint64_t i = 0; i < draws; i++) {
+        x ^= generator();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink ^= x;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / double(draws);
+}
+
+// Known-answer tests from the Random123 suite and the xoshiro reference code
+static bool knownAnswers() {
+    bool ok = true;
+    const Philox4x32::Block zero = Philox4x32::generate({ 0, 0, 0, 0 }, { 0, 0 });
+    ok &= zero == Philox4x32::Block{ 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u };
+    const Philox4x32::Block ones = Philox4x32::generate({ 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu },
+                                                        { 0xffffffffu, 0xffffffffu });
+    ok &= ones == Philox4x32::Block{ 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu };
+    const Philox4x32::Block pi = Philox4x32::generate({ 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u },
+                                                      { 0xa4093822u, 0x299f31d0u });
+    ok &= pi == Philox4x32::Block{ 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u };
+    Xoshiro256pp xoshiro(std::array<std::uint64_t, 4>{ 1, 2, 3, 4 });
+    ok &= xoshiro() == 41943041u;
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    std::uint32_t colonies = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000;
+    std::uint32_t turns = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1000;
+    std::uint64_t draws = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100000000;
+    bool ok = knownAnswers();
+    std::cout << "known answers: " << (ok ? "ok" : "MISMATCH") << std::endl;
+
+    AliasTable table;
+    table.build({ 10, 10, 8, 5, 67 });
+    const std::uint64_t seed = 12345;
+    const std::size_t keys = std::size_t(colonies) * turns;
+
+    for(RngKind kind : { RngKind::Philox, RngKind::Xoshiro }) {
+        auto roll = [&](std::size_t key) {
+            RandomStream stream(kind, RngKey{ seed, static_cast<std::uint32_t>(key / turns),
+                                              static_cast<std::uint32_t>(key % turns), RngSubsystem::Events });
+            return static_cast<std::uint8_t>(table.sample(stream));
+        };
+        std::vector<std::uint8_t> serial(keys);
+        for(std::size_t key = 0; key < keys; key++) {
+            serial[key] = roll(key);
+        }
+
+        // Same keys, scrambled across threads
+        std::vector<std::uint8_t> parallel(keys);
+        WorkerPool workers(std::max(2u, std::thread::hardware_concurrency()));
+        const std::size_t chunk = 4096;
+        const std::size_t chunks = (keys + chunk - 1) / chunk;
+        workers.run(chunks, [&](std::size_t c) {
+            std::size_t scrambled = (c * 7919) % chunks;
+            for(std::size_t key = scrambled * chunk; key < std::min(keys, (scrambled + 1) * chunk); key++) {
+                parallel[key] = roll(key);
+            }
+        });
+        bool same = serial == parallel;
+        ok &= same;
+        std::cout << (kind == RngKind::Philox ? "philox" : "xoshiro") << " rolls for " << keys
+                  << " (colony, turn) keys: " << (same ? "identical" : "MISMATCH") << std::endl;
+    }
+
+    std::uint64_t sink = 0;
+    std::cout << "ns per 64-bit draw:" << std::endl;
+    std::cout << "  mt19937_64    " << nsPerDraw(std::mt19937_64(seed), draws, sink) << std::endl;
+    std::cout << "  xoshiro256++  " << nsPerDraw(Xoshiro256pp(seed), draws, sink) << std::endl;
+    std::cout << "  philox stream " << nsPerDraw(PhiloxStream(RngKey{ seed, 0, 0, RngSubsystem::Events }), draws, sink)
+              << std::endl;
+    std::cout << "  RandomStream  " << nsPerDraw(RandomStream(RngKind::Philox, RngKey{ seed, 0, 0, RngSubsystem::Events }),
+                                                  draws, sink) << std::endl;
+    std::cout << "state bytes: mt19937 " << sizeof(std::mt19937) << ", xoshiro256++ " << sizeof(Xoshiro256pp)
+              << ", philox stream " << sizeof(PhiloxStream) << " (checksum " << (sink & 0xff) << ")" << std::endl;
+    return ok ? 0 : 1;
+}
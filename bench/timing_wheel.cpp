@@ -0,0 +1,99 @@
+// Benchmark of the event TimingWheel with millions of pending timers:
+// insert, cancel and per-turn advance cost over a long run. Exits 1 if any
+// timer fires on the wrong turn, fires twice or is lost, or if cancelling
+// from inside a callback goes wrong.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o timing_wheel bench/timing_wheel.cpp
+// Run:   ./timing_wheel [timers] [turns]   (default: 5000000 1000000)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+#include "bench_util.h"
+
+#include <cstdlib>
+
+struct Timer {
+    std::uint64_t due;
+    std::uint32_t id;
+};
+
+// A callback that cancels timers due in the same slot, then inserts new ones
+// into the nodes it freed: the cancelled timers must not fire and every
+// other timer must fire exactly once
+static bool cancelInsideCallbackWorks() {
+    TimingWheel<Timer> wheel;
+    std::vector<TimingWheel<Timer>::Handle> handles;
+    for(std::uint32_t i = 0; i < 8; i++) {
+        handles.push_back(wheel.insert(5, Timer{ 5, i }));
+    }
+    handles.push_back(wheel.insert(6, Timer{ 6, 8 }));
+
+    std::vector<int> fired(16, 0);
+    bool correct = true;
+    wheel.advance(10, [&](const Timer& timer) {
+        fired[timer.id]++;
+        correct = correct && timer.due == wheel.currentTurn();
+        if(timer.id == 7) {
+            // Entries are fired newest first, so 6 is the next one due
+            correct = correct && wheel.cancel(handles[6]) && wheel.cancel(handles[3]) && wheel.cancel(handles[0]) &&
+                      wheel.cancel(handles[8]) && !wheel.cancel(handles[7]) && !wheel.cancel(handles[3]);
+            wheel.insert(7, Timer{ 7, 9 });
+            wheel.insert(7, Timer{ 7, 10 });
+        }
+    });
+    for(std::uint32_t i = 0; i < 11; i++) {
+        bool cancelledTimer = i == 0 || i == 3 || i == 6 || i == 8;
+        correct = correct && fired[i] == (cancelledTimer ? 0 : 1);
+    }
+    return correct && wheel.empty();
+}
+
+int main(int argc, char* argv[]) {
+    if(!cancelInsideCallbackWorks()) {
+        std::cout << "MISMATCH: cancelling from inside a callback" << std::endl;
+        return 1;
+    }
+
+    std::size_t timerCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    std::uint64_t turns = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+    std::mt19937_64 generator(12345);
+    std::uniform_int_distribution<std::uint64_t> dueRoll(1, turns);
+    TimingWheel<Timer> wheel;
+    std::vector<TimingWheel<Timer>::Handle> handles(timerCount);
+    std::vector<std::uint8_t> cancelled(timerCount, 0);
+    std::vector<std::uint8_t> fired(timerCount, 0);
+
+    double insertMs = timeMs([&] {
+        for(std::size_t i = 0; i < timerCount; i++) {
+            std::uint64_t due = dueRoll(generator);
+            handles[i] = wheel.insert(due, Timer{ due, static_cast<std::uint32_t>(i) });
+        }
+    });
+
+    // Cancel every tenth timer
+    std::size_t cancelCount = 0;
+    double cancelMs = timeMs([&] {
+        for(std::size_t i = 0; i < timerCount; i += 10) {
+            cancelled[i] = wheel.cancel(handles[i]);
+            cancelCount += cancelled[i];
+        }
+    });
+
+    bool correct = true;
+    std::size_t firedCount = 0;
+    double advanceMs = timeMs([&] {
+        wheel.advance(turns, [&](const Timer& timer) {
+            correct = correct && timer.due == wheel.currentTurn() && !fired[timer.id] && !cancelled[timer.id];
+            fired[timer.id] = 1;
+            firedCount++;
+        });
+    });
+    correct = correct && firedCount + cancelCount == timerCount && wheel.empty();
+
+    std::cout << timerCount << " timers over " << turns << " turns" << std::endl;
+    std::cout << "  insert:  " << insertMs * 1e6 / timerCount << " ns/timer" << std::endl;
+    std::cout << "  cancel:  " << cancelMs * 1e6 / std::max<std::size_t>(1, cancelCount) << " ns/timer" << std::endl;
+    std::cout << "  advance: " << advanceMs * 1e6 / turns << " ns/turn, " << firedCount << " fired"
+              << (correct ? "" : "  MISMATCH") << std::endl;
+    return correct ? 0 : 1;
+}
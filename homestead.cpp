@@ -1,14 +1,28 @@
 #include <iostream>
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
 #include <map>
 #include <memory>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <random>
 #include <algorithm>
 #include <stdexcept>
 #include <chrono>
 #include <thread>
+#include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <type_traits>
+#include <cctype>
+#include <variant>
+#include <utility>
+#include <charconv>
 
 // Custom Exception Classes
 class ResourceException : public std::exception {
@@ -35,107 +49,514 @@ public:
     const char* what() const noexcept override { return message.c_str(); }
 };
 
+#ifdef HOMESTEAD_VERIFY_AGGREGATE
+// A failed cross-check means the cached state is already wrong, so it aborts
+// rather than throwing into the game loop's error recovery
+[[noreturn]] inline void verifyFailed(const std::string& what) {
+    std::cerr << "HOMESTEAD_VERIFY_AGGREGATE: " << what << std::endl;
+    std::abort();
+}
+#endif
+
 // Forward declarations
 class GameEngine;
 class GameState;
 class Building;
-class Colonist;
 class Event;
 
-// Resource Management Class with Operator Overloading
-class Resource {
+// Built-in resource types. Their values are the registry IDs they are
+// interned under, so hot paths can index a Resource without a name lookup.
+// The order is alphabetical so display and save output keep the layout the
+// old name-keyed map produced.
+enum class ResourceType : std::uint16_t {
+    Energy,
+    Food,
+    Materials,
+    Oxygen,
+    Count
+};
+
+using ResourceId = std::uint16_t;
+
+constexpr std::size_t kBuiltinResourceCount = static_cast<std::size_t>(ResourceType::Count);
+
+// Upper bound on registered resource types (built-ins plus config-defined).
+// Resource reserves this many lanes inline so it never allocates.
+constexpr std::size_t kMaxResourceTypes = 16;
+
+constexpr ResourceId resourceId(ResourceType type) {
+    return static_cast<ResourceId>(type);
+}
+
+// Process-wide table interning resource names into small dense IDs.
+// Built-ins are registered first; config.txt may add more at startup.
+class ResourceRegistry {
 private:
-    std::map<std::string, int> resources;
+    std::vector<std::string> names;
+    std::map<std::string, ResourceId> ids;
+
+    ResourceRegistry() {
+        static const char* const builtins[kBuiltinResourceCount] = { "energy", "food", "materials", "oxygen" };
+        for(const char* name : builtins) {
+            intern(name);
+        }
+    }
+
+public:
+    static ResourceRegistry& instance() {
+        static ResourceRegistry registry;
+        return registry;
+    }
+
+    // Returns the ID for name, registering it if it is new
+    ResourceId intern(const std::string& name) {
+        auto it = ids.find(name);
+        if(it != ids.end()) {
+            return it->second;
+        }
+        if(names.size() >= kMaxResourceTypes) {
+            throw ResourceException("Too many resource types, cannot register " + name);
+        }
+        ResourceId id = static_cast<ResourceId>(names.size());
+        names.push_back(name);
+        ids[name] = id;
+        return id;
+    }
+
+    bool find(const std::string& name, ResourceId& id) const {
+        auto it = ids.find(name);
+        if(it == ids.end()) {
+            return false;
+        }
+        id = it->second;
+        return true;
+    }
+
+    const std::string& name(ResourceId id) const { return names[id]; }
+    std::size_t size() const { return names.size(); }
+};
+
+// Arithmetic policies for BasicResource, chosen at compile time. Each names
+// the lane type, the element-wise add/sub the kernels use, and narrow(),
+// which brings a 64-bit intermediate into a lane the same way add() would.
+// All three are written without branches so the fixed-width loops stay
+// vectorizable.
+
+// 32-bit lanes with two's complement wraparound (the old int behaviour,
+// without the undefined overflow)
+struct WrappingInt32Policy {
+    using Quantity = std::int32_t;
+
+    static Quantity add(Quantity a, Quantity b) {
+        return static_cast<Quantity>(static_cast<std::uint32_t>(a) + static_cast<std::uint32_t>(b));
+    }
+
+    static Quantity sub(Quantity a, Quantity b) {
+        return static_cast<Quantity>(static_cast<std::uint32_t>(a) - static_cast<std::uint32_t>(b));
+    }
+
+    static Quantity narrow(std::int64_t wide) {
+        return static_cast<Quantity>(static_cast<std::uint32_t>(static_cast<std::uint64_t>(wide)));
+    }
+};
+
+// 32-bit lanes that clamp to INT32_MIN/INT32_MAX instead of wrapping. The
+// result is computed wrapped and replaced by the saturation bound, picked
+// from the sign of a, when the sign bits show an overflow.
+struct SaturatingInt32Policy {
+    using Quantity = std::int32_t;
+
+    static Quantity add(Quantity a, Quantity b) {
+        std::uint32_t ua = static_cast<std::uint32_t>(a);
+        std::uint32_t ub = static_cast<std::uint32_t>(b);
+        std::uint32_t sum = ua + ub;
+        std::uint32_t bound = (ua >> 31) + static_cast<std::uint32_t>(INT32_MAX);
+        bool overflow = static_cast<std::int32_t>(~(ua ^ ub) & (ua ^ sum)) < 0;
+        return static_cast<Quantity>(overflow ? bound : sum);
+    }
+
+    static Quantity sub(Quantity a, Quantity b) {
+        std::uint32_t ua = static_cast<std::uint32_t>(a);
+        std::uint32_t ub = static_cast<std::uint32_t>(b);
+        std::uint32_t diff = ua - ub;
+        std::uint32_t bound = (ua >> 31) + static_cast<std::uint32_t>(INT32_MAX);
+        bool overflow = static_cast<std::int32_t>((ua ^ ub) & (ua ^ diff)) < 0;
+        return static_cast<Quantity>(overflow ? bound : diff);
+    }
+
+    static Quantity narrow(std::int64_t wide) {
+        return static_cast<Quantity>(std::min<std::int64_t>(std::max<std::int64_t>(wide, INT32_MIN), INT32_MAX));
+    }
+};
+
+// 64-bit lanes; wide enough that long-horizon runs do not overflow
+struct Int64Policy {
+    using Quantity = std::int64_t;
+
+    static Quantity add(Quantity a, Quantity b) { return a + b; }
+    static Quantity sub(Quantity a, Quantity b) { return a - b; }
+    static Quantity narrow(std::int64_t wide) { return wide; }
+};
+
+#ifndef HOMESTEAD_RESOURCE_POLICY
+#define HOMESTEAD_RESOURCE_POLICY Int64Policy
+#endif
+
+template<typename Policy>
+struct BasicConsumeResult;
+
+template<typename E>
+struct ResourceExpr;
+
+// How tryConsume() behaves when the stock cannot cover the full request
+enum class ConsumeMode {
+    AllOrNothing,   // leave the stock untouched unless every resource is covered
+    Clamp           // take what is there and floor short resources at zero
+};
 
+// Resource Management Class with Operator Overloading
+template<typename Policy>
+class BasicResource {
 public:
-    Resource() {
-        resources["food"] = 100;
-        resources["energy"] = 100;
-        resources["materials"] = 50;
-        resources["oxygen"] = 100;
+    using ArithmeticPolicy = Policy;
+    using Quantity = typename Policy::Quantity;
+
+private:
+    template<typename P>
+    friend struct BasicConsumeResult;
+
+    // One lane per possible resource ID, aligned so the element-wise kernels
+    // below compile to straight vector loads/stores with a fixed trip count.
+    // Lanes beyond the registry's current size stay zero.
+    alignas(32) std::array<Quantity, kMaxResourceTypes> amounts{};
+
+    static void addKernel(Quantity* dst, const Quantity* src) {
+        for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+            dst[i] = Policy::add(dst[i], src[i]);
+        }
+    }
+
+    static void subKernel(Quantity* dst, const Quantity* src) {
+        for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+            dst[i] = Policy::sub(dst[i], src[i]);
+        }
+    }
+
+    [[noreturn]] static void throwShortfall(const Quantity* values) {
+        std::size_t shortId = 0;
+        while(values[shortId] >= 0) shortId++;
+        throw ResourceException("Insufficient " + ResourceRegistry::instance().name(static_cast<ResourceId>(shortId)));
     }
 
-    // Operator overloading for resource management
-    Resource operator+(const Resource& other) const {
-        Resource result = *this;
-        for(const auto& pair : other.resources) {
-            result.resources[pair.first] += pair.second;
+    // Branch-free reductions: OR-ing the lanes keeps the sign bit if any lane is negative
+    static bool anyNegativeKernel(const Quantity* values) {
+        Quantity merged = 0;
+        for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+            merged |= values[i];
+        }
+        return merged < 0;
+    }
+
+    static bool allGreaterEqualKernel(const Quantity* lhs, const Quantity* rhs) {
+        bool result = true;
+        for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+            result &= lhs[i] >= rhs[i];
         }
         return result;
     }
 
-    Resource operator-(const Resource& other) const {
-        Resource result = *this;
-        for(const auto& pair : other.resources) {
-            result.resources[pair.first] -= pair.second;
-            if(result.resources[pair.first] < 0) {
-                throw ResourceException("Insufficient " + pair.first);
-            }
+public:
+    // A default-constructed Resource is an empty delta; use startingStock()
+    // for a fresh colony's supplies.
+    BasicResource() = default;
+
+    static BasicResource startingStock() {
+        BasicResource stock;
+        stock[ResourceType::Food] = 100;
+        stock[ResourceType::Energy] = 100;
+        stock[ResourceType::Materials] = 50;
+        stock[ResourceType::Oxygen] = 100;
+        return stock;
+    }
+
+    // Materialize a lazy expression such as a + b - c in one pass. One that
+    // subtracts throws like operator-= if its value is negative anywhere.
+    template<typename E>
+    BasicResource(const ResourceExpr<E>& expr) {
+        const E& lanes = expr.self();
+        for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+            amounts[i] = lanes.lane(i);
         }
+        if(E::kChecked && anyNegativeKernel(amounts.data())) {
+            throwShortfall(amounts.data());
+        }
+    }
+
+    // Operator overloading for resource management. operator+ and an
+    // operator- with an expression on either side build the lazy
+    // expressions defined below the class; Resource - Resource stays eager.
+    BasicResource operator-(const BasicResource& other) const {
+        BasicResource result = *this;
+        result -= other;
         return result;
     }
 
-    Resource& operator+=(const Resource& other) {
-        *this = *this + other;
+    // In-place accumulation: no temporary Resource is created
+    BasicResource& operator+=(const BasicResource& other) {
+        addKernel(amounts.data(), other.amounts.data());
         return *this;
     }
 
-    Resource& operator-=(const Resource& other) {
-        *this = *this - other;
+    // Fused accumulation: total += a + b + c reads each operand once and
+    // writes total once. An expression that subtracts is materialized
+    // first so a negative value leaves total unchanged.
+    template<typename E>
+    BasicResource& operator+=(const ResourceExpr<E>& expr) {
+        if constexpr(E::kChecked) {
+            return *this += BasicResource(expr);
+        } else {
+            const E& lanes = expr.self();
+            for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+                amounts[i] = Policy::add(amounts[i], lanes.lane(i));
+            }
+            return *this;
+        }
+    }
+
+    // Leaves *this unchanged if any resource would go negative
+    BasicResource& operator-=(const BasicResource& other) {
+        BasicResource result = *this;
+        subKernel(result.amounts.data(), other.amounts.data());
+        if(anyNegativeKernel(result.amounts.data())) {
+            throwShortfall(result.amounts.data());
+        }
+        amounts = result.amounts;
         return *this;
     }
 
-    int& operator[](const std::string& resourceType) {
-        return resources[resourceType];
+    // Lane read used by the lazy expressions
+    Quantity lane(std::size_t i) const { return amounts[i]; }
+
+    bool operator==(const BasicResource& other) const { return amounts == other.amounts; }
+    bool operator!=(const BasicResource& other) const { return amounts != other.amounts; }
+
+    // ID-based access for hot paths
+    Quantity& operator[](ResourceId id) { return amounts[id]; }
+    const Quantity& operator[](ResourceId id) const { return amounts[id]; }
+    Quantity& operator[](ResourceType type) { return amounts[resourceId(type)]; }
+    const Quantity& operator[](ResourceType type) const { return amounts[resourceId(type)]; }
+
+    // Name-based access for save files and config; names must be registered
+    Quantity& operator[](const std::string& resourceType) {
+        return amounts[lookup(resourceType)];
+    }
+
+    const Quantity& operator[](const std::string& resourceType) const {
+        return amounts[lookup(resourceType)];
     }
 
-    const int& operator[](const std::string& resourceType) const {
-        auto it = resources.find(resourceType);
-        if(it == resources.end()) {
+    static ResourceId lookup(const std::string& resourceType) {
+        ResourceId id;
+        if(!ResourceRegistry::instance().find(resourceType, id)) {
             throw ResourceException("Unknown resource type: " + resourceType);
         }
-        return it->second;
+        return id;
     }
 
-    bool canAfford(const Resource& cost) const {
-        for(const auto& pair : cost.resources) {
-            auto it = resources.find(pair.first);
-            if(it == resources.end() || it->second < pair.second) {
-                return false;
-            }
-        }
-        return true;
+    bool canAfford(const BasicResource& cost) const {
+        return allGreaterEqualKernel(amounts.data(), cost.amounts.data());
     }
 
-    void display() const {
-        std::cout << "Resources: ";
-        for(const auto& pair : resources) {
-            std::cout << pair.first << ":" << pair.second << " ";
+    // Non-throwing counterpart to operator-=. Negative entries in cost are
+    // gains, so a signed delta can be applied by passing its negation.
+    BasicConsumeResult<Policy> tryConsume(const BasicResource& cost, ConsumeMode mode = ConsumeMode::AllOrNothing);
+
+    void display(std::ostream& out = std::cout) const {
+        const ResourceRegistry& registry = ResourceRegistry::instance();
+        out << "Resources: ";
+        for(std::size_t i = 0; i < registry.size(); i++) {
+            out << registry.name(static_cast<ResourceId>(i)) << ":" << amounts[i] << " ";
         }
-        std::cout << std::endl;
+        out << std::endl;
     }
 
     // File I/O support
     void saveToFile(std::ofstream& file) const {
-        file << resources.size() << std::endl;
-        for(const auto& pair : resources) {
-            file << pair.first << " " << pair.second << std::endl;
+        const ResourceRegistry& registry = ResourceRegistry::instance();
+        file << registry.size() << std::endl;
+        for(std::size_t i = 0; i < registry.size(); i++) {
+            file << registry.name(static_cast<ResourceId>(i)) << " " << amounts[i] << std::endl;
         }
     }
 
     void loadFromFile(std::ifstream& file) {
         int count;
         file >> count;
-        resources.clear();
+        amounts.fill(0);
         for(int i = 0; i < count; i++) {
             std::string type;
-            int amount;
+            Quantity amount;
             file >> type >> amount;
-            resources[type] = amount;
+            (*this)[type] = amount;
+        }
+    }
+};
+
+using Resource = BasicResource<HOMESTEAD_RESOURCE_POLICY>;
+
+// Lazy expressions for a + b - c and the like: each lane is computed on
+// demand, so nothing is materialized until the expression is assigned to or
+// accumulated into a Resource. Resource operands are held by reference and
+// nested expressions by value, so an expression stays valid as long as the
+// Resources it names do. kChecked marks an expression that subtracts.
+template<typename E>
+struct ResourceExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// How an expression holds one operand, and whether that operand subtracts
+template<typename T>
+struct ResourceOperand {
+    using Type = T;
+    static constexpr bool kChecked = T::kChecked;
+};
+
+template<typename P>
+struct ResourceOperand<BasicResource<P>> {
+    using Type = const BasicResource<P>&;
+    static constexpr bool kChecked = false;
+};
+
+template<typename L, typename R>
+class ResourceSum : public ResourceExpr<ResourceSum<L, R>> {
+public:
+    using ArithmeticPolicy = typename L::ArithmeticPolicy;
+    using Quantity = typename ArithmeticPolicy::Quantity;
+
+    static constexpr bool kChecked = ResourceOperand<L>::kChecked || ResourceOperand<R>::kChecked;
+
+private:
+    typename ResourceOperand<L>::Type lhs;
+    typename ResourceOperand<R>::Type rhs;
+
+public:
+    ResourceSum(const L& left, const R& right) : lhs(left), rhs(right) {}
+
+    Quantity lane(std::size_t i) const { return ArithmeticPolicy::add(lhs.lane(i), rhs.lane(i)); }
+};
+
+template<typename L, typename R>
+class ResourceDifference : public ResourceExpr<ResourceDifference<L, R>> {
+public:
+    using ArithmeticPolicy = typename L::ArithmeticPolicy;
+    using Quantity = typename ArithmeticPolicy::Quantity;
+
+    static constexpr bool kChecked = true;
+
+private:
+    typename ResourceOperand<L>::Type lhs;
+    typename ResourceOperand<R>::Type rhs;
+
+public:
+    ResourceDifference(const L& left, const R& right) : lhs(left), rhs(right) {}
+
+    Quantity lane(std::size_t i) const { return ArithmeticPolicy::sub(lhs.lane(i), rhs.lane(i)); }
+};
+
+template<typename P>
+ResourceSum<BasicResource<P>, BasicResource<P>> operator+(const BasicResource<P>& lhs, const BasicResource<P>& rhs) {
+    return ResourceSum<BasicResource<P>, BasicResource<P>>(lhs, rhs);
+}
+
+template<typename E>
+ResourceSum<E, BasicResource<typename E::ArithmeticPolicy>>
+operator+(const ResourceExpr<E>& lhs, const BasicResource<typename E::ArithmeticPolicy>& rhs) {
+    return ResourceSum<E, BasicResource<typename E::ArithmeticPolicy>>(lhs.self(), rhs);
+}
+
+template<typename E>
+ResourceSum<BasicResource<typename E::ArithmeticPolicy>, E>
+operator+(const BasicResource<typename E::ArithmeticPolicy>& lhs, const ResourceExpr<E>& rhs) {
+    return ResourceSum<BasicResource<typename E::ArithmeticPolicy>, E>(lhs, rhs.self());
+}
+
+template<typename E1, typename E2>
+ResourceSum<E1, E2> operator+(const ResourceExpr<E1>& lhs, const ResourceExpr<E2>& rhs) {
+    return ResourceSum<E1, E2>(lhs.self(), rhs.self());
+}
+
+template<typename E>
+ResourceDifference<E, BasicResource<typename E::ArithmeticPolicy>>
+operator-(const ResourceExpr<E>& lhs, const BasicResource<typename E::ArithmeticPolicy>& rhs) {
+    return ResourceDifference<E, BasicResource<typename E::ArithmeticPolicy>>(lhs.self(), rhs);
+}
+
+template<typename E>
+ResourceDifference<BasicResource<typename E::ArithmeticPolicy>, E>
+operator-(const BasicResource<typename E::ArithmeticPolicy>& lhs, const ResourceExpr<E>& rhs) {
+    return ResourceDifference<BasicResource<typename E::ArithmeticPolicy>, E>(lhs, rhs.self());
+}
+
+template<typename E1, typename E2>
+ResourceDifference<E1, E2> operator-(const ResourceExpr<E1>& lhs, const ResourceExpr<E2>& rhs) {
+    return ResourceDifference<E1, E2>(lhs.self(), rhs.self());
+}
+
+// Outcome of Resource::tryConsume, listing what could not be covered
+template<typename Policy>
+struct BasicConsumeResult {
+    bool satisfied = true;
+    std::uint32_t shortMask = 0;        // bit i set when resource ID i fell short
+    BasicResource<Policy> shortfall;    // missing amount per resource
+
+    bool isShort(ResourceId id) const { return (shortMask >> id) & 1u; }
+
+    std::string describe() const {
+        const ResourceRegistry& registry = ResourceRegistry::instance();
+        std::string text;
+        for(std::size_t i = 0; i < registry.size(); i++) {
+            ResourceId id = static_cast<ResourceId>(i);
+            if(isShort(id)) {
+                if(!text.empty()) text += ", ";
+                text += registry.name(id) + " short by " + std::to_string(shortfall[id]);
+            }
         }
+        return text;
     }
 };
 
+using ConsumeResult = BasicConsumeResult<HOMESTEAD_RESOURCE_POLICY>;
+
+static_assert(kMaxResourceTypes <= 32, "ConsumeResult::shortMask needs one bit per resource type");
+
+template<typename Policy>
+BasicConsumeResult<Policy> BasicResource<Policy>::tryConsume(const BasicResource& cost, ConsumeMode mode) {
+    BasicConsumeResult<Policy> result;
+    Quantity* missing = result.shortfall.amounts.data();
+    Quantity anyMissing = 0;
+    for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+        Quantity remaining = Policy::sub(amounts[i], cost.amounts[i]);
+        missing[i] = remaining < 0 ? Policy::sub(0, remaining) : 0;
+        anyMissing |= missing[i];
+    }
+
+    if(anyMissing != 0) {
+        result.satisfied = false;
+        for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+            result.shortMask |= static_cast<std::uint32_t>(missing[i] != 0) << i;
+        }
+        if(mode == ConsumeMode::AllOrNothing) {
+            return result;
+        }
+    }
+
+    for(std::size_t i = 0; i < kMaxResourceTypes; i++) {
+        Quantity remaining = Policy::sub(amounts[i], cost.amounts[i]);
+        amounts[i] = remaining < 0 ? 0 : remaining;
+    }
+    return result;
+}
+
 // Base Production Interface for Polymorphism
 class Producible {
 public:
@@ -144,396 +565,3793 @@ public:
     virtual std::string getProductionInfo() const = 0;
 };
 
-// Base Building Class using Inheritance
-class Building : public Producible {
-protected:
+enum class BuildingType : std::uint8_t {
+    SolarPanel,
+    Greenhouse,
+    OxygenGenerator,
+    MaterialFactory,
+    Count
+};
+
+constexpr std::size_t kBuildingTypeCount = static_cast<std::size_t>(BuildingType::Count);
+
+class SolarPanel;
+class Greenhouse;
+class OxygenGenerator;
+class MaterialFactory;
+
+struct ResourceAmount {
+    ResourceType type;
+    Resource::Quantity amount;
+};
+
+// Compile-time building definitions; the single source of truth for names,
+// costs and rates. A building at level L produces
+// (baseRate + upgradeRate * (L - 1)) * L of its output resource.
+template<typename T>
+struct BuildingTraits;
+
+template<>
+struct BuildingTraits<SolarPanel> {
+    static constexpr BuildingType type = BuildingType::SolarPanel;
+    static constexpr const char* name = "Solar Panel";
+    static constexpr const char* saveKey = "SolarPanel";
+    static constexpr ResourceType output = ResourceType::Energy;
+    static constexpr Resource::Quantity baseRate = 15;
+    static constexpr Resource::Quantity upgradeRate = 0;
+    static constexpr std::array<ResourceAmount, 1> cost = {{ {ResourceType::Materials, 20} }};
+};
+
+template<>
+struct BuildingTraits<Greenhouse> {
+    static constexpr BuildingType type = BuildingType::Greenhouse;
+    static constexpr const char* name = "Greenhouse";
+    static constexpr const char* saveKey = "Greenhouse";
+    static constexpr ResourceType output = ResourceType::Food;
+    static constexpr Resource::Quantity baseRate = 20;
+    static constexpr Resource::Quantity upgradeRate = 0;
+    static constexpr std::array<ResourceAmount, 2> cost = {{ {ResourceType::Materials, 30}, {ResourceType::Energy, 10} }};
+};
+
+template<>
+struct BuildingTraits<OxygenGenerator> {
+    static constexpr BuildingType type = BuildingType::OxygenGenerator;
+    static constexpr const char* name = "Oxygen Generator";
+    static constexpr const char* saveKey = "OxygenGenerator";
+    static constexpr ResourceType output = ResourceType::Oxygen;
+    static constexpr Resource::Quantity baseRate = 10;
+    static constexpr Resource::Quantity upgradeRate = 0;
+    static constexpr std::array<ResourceAmount, 2> cost = {{ {ResourceType::Materials, 25}, {ResourceType::Energy, 15} }};
+};
+
+// Upgrades have always added 5 materials to a building's rates, which only
+// shows up in the output of the one building that produces materials
+template<>
+struct BuildingTraits<MaterialFactory> {
+    static constexpr BuildingType type = BuildingType::MaterialFactory;
+    static constexpr const char* name = "Material Factory";
+    static constexpr const char* saveKey = "MaterialFactory";
+    static constexpr ResourceType output = ResourceType::Materials;
+    static constexpr Resource::Quantity baseRate = 8;
+    static constexpr Resource::Quantity upgradeRate = 5;
+    static constexpr std::array<ResourceAmount, 2> cost = {{ {ResourceType::Materials, 40}, {ResourceType::Energy, 20} }};
+};
+
+// Every building class, in BuildingType order
+template<typename... Ts>
+struct BuildingList {};
+
+using AllBuildingTypes = BuildingList<SolarPanel, Greenhouse, OxygenGenerator, MaterialFactory>;
+
+// Calls visit(BuildingTraits<T>{}) for each building type in order
+template<typename Visitor, typename... Ts>
+void forEachBuildingType(BuildingList<Ts...>, Visitor&& visit) {
+    (visit(BuildingTraits<Ts>{}), ...);
+}
+
+template<typename Visitor>
+void forEachBuildingType(Visitor&& visit) {
+    forEachBuildingType(AllBuildingTypes{}, visit);
+}
+
+// Levels are stored in 16 bits; upgrades stop at the top level
+constexpr int kMaxBuildingLevel = std::numeric_limits<std::uint16_t>::max();
+
+constexpr bool isSaveToken(const char* text) {
+    if(text[0] == '\0') return false;
+    for(; *text != '\0'; text++) {
+        if(*text == ' ' || *text == '\t' || *text == '\n') return false;
+    }
+    return true;
+}
+
+template<typename T>
+constexpr bool validBuildingTraits() {
+    using Traits = BuildingTraits<T>;
+    bool valid = Traits::name[0] != '\0' && isSaveToken(Traits::saveKey) &&
+                 Traits::output != ResourceType::Count && Traits::baseRate > 0 && Traits::upgradeRate >= 0 &&
+                 std::int64_t(Traits::baseRate) + std::int64_t(Traits::upgradeRate) * (kMaxBuildingLevel - 1) <=
+                     std::numeric_limits<std::int64_t>::max() / kMaxBuildingLevel;
+    for(const ResourceAmount& entry : Traits::cost) {
+        valid = valid && entry.type != ResourceType::Count && entry.amount > 0;
+    }
+    return valid;
+}
+
+template<typename... Ts>
+constexpr bool validBuildingList(BuildingList<Ts...>) {
+    bool valid = sizeof...(Ts) == kBuildingTypeCount;
+    std::size_t index = 0;
+    ((valid = valid && validBuildingTraits<Ts>() && static_cast<std::size_t>(BuildingTraits<Ts>::type) == index++), ...);
+    return valid;
+}
+
+static_assert(validBuildingList(AllBuildingTypes{}),
+              "BuildingTraits must have names, save keys without spaces, positive rates and costs, "
+              "output at kMaxBuildingLevel that fits 64 bits, and AllBuildingTypes must list every "
+              "BuildingType in enum order");
+
+// Total output of one operational building at the given level, shared by
+// the traits-based classes and the runtime table. A MaterialFactory near
+// the top level makes more than 2^31, so the product is taken in 64 bits
+// and narrowed by the policy.
+Resource::Quantity buildingOutput(std::int64_t baseRate, std::int64_t upgradeRate, int level) {
+    return Resource::ArithmeticPolicy::narrow((baseRate + upgradeRate * (level - 1)) * level);
+}
+
+// Runtime view of the traits table for code that only knows a BuildingType.
+// Shared by every building of one type (flyweight); building instances only
+// carry their type, level and operational flag.
+struct BuildingTypeInfo {
     std::string name;
+    std::string saveKey;
+    std::string costLabel;      // e.g. "Materials: 30, Energy: 10"
+    ResourceType output;        // resource the building produces
     Resource cost;
-    Resource production;
+    Resource::Quantity baseRate;
+    Resource::Quantity upgradeRate;
+
+    // Per-level output rate of the produced resource
+    Resource::Quantity outputRate(int level) const {
+        return baseRate + upgradeRate * (level - 1);
+    }
+
+    // Total output of one operational building at the given level
+    Resource::Quantity outputAt(int level) const {
+        return buildingOutput(baseRate, upgradeRate, level);
+    }
+};
+
+const BuildingTypeInfo& buildingTypeInfo(BuildingType type) {
+    static const std::array<BuildingTypeInfo, kBuildingTypeCount> table = [] {
+        std::array<BuildingTypeInfo, kBuildingTypeCount> types;
+        forEachBuildingType([&](auto traits) {
+            using Traits = decltype(traits);
+            BuildingTypeInfo& info = types[static_cast<std::size_t>(Traits::type)];
+            info.name = Traits::name;
+            info.saveKey = Traits::saveKey;
+            info.output = Traits::output;
+            info.baseRate = Traits::baseRate;
+            info.upgradeRate = Traits::upgradeRate;
+            for(const ResourceAmount& entry : Traits::cost) {
+                std::string label = ResourceRegistry::instance().name(resourceId(entry.type));
+                label[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(label[0])));
+                if(!info.costLabel.empty()) info.costLabel += ", ";
+                info.costLabel += label + ": " + std::to_string(entry.amount);
+                info.cost[entry.type] = entry.amount;
+            }
+        });
+        return types;
+    }();
+    return table[static_cast<std::size_t>(type)];
+}
+
+// What one building produced in a turn. Reports are passed around in this
+// form and only turned into text by a sink that actually prints them.
+struct ProductionRecord {
+    BuildingType type;
     int level;
+    Resource::Quantity amount;
+
+    std::string format() const {
+        const BuildingTypeInfo& info = buildingTypeInfo(type);
+        return info.name + " Level " + std::to_string(level) + 
+               " produces " + std::to_string(amount) + " " +
+               ResourceRegistry::instance().name(resourceId(info.output));
+    }
+};
+
+// Consumer of per-building production reports
+class ProductionSink {
+public:
+    virtual ~ProductionSink() = default;
+
+    // When false the engine skips building records altogether
+    virtual bool wantsRecords() const = 0;
+    virtual void consume(const ProductionRecord& record) = 0;
+};
+
+// Formats each record as a line on a stream, by default std::cout
+class ConsoleProductionSink : public ProductionSink {
+private:
+    std::ostream& out;
+
+public:
+    explicit ConsoleProductionSink(std::ostream& stream = std::cout) : out(stream) {}
+
+    bool wantsRecords() const override { return true; }
+    void consume(const ProductionRecord& record) override {
+        out << record.format() << std::endl;
+    }
+};
+
+// Drops every record; used when nobody is watching
+class NullProductionSink : public ProductionSink {
+public:
+    bool wantsRecords() const override { return false; }
+    void consume(const ProductionRecord&) override {}
+};
+
+bool buildingTypeFromKey(const std::string& key, BuildingType& type) {
+    for(std::size_t i = 0; i < kBuildingTypeCount; i++) {
+        if(buildingTypeInfo(static_cast<BuildingType>(i)).saveKey == key) {
+            type = static_cast<BuildingType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Base Building Class using Inheritance
+class Building : public Producible {
+protected:
+    BuildingType type;
+    std::uint16_t level;
     bool operational;
 
 public:
-    Building(const std::string& buildingName) : 
-        name(buildingName), level(1), operational(true) {}
+    Building(BuildingType buildingType) : 
+        type(buildingType), level(1), operational(true) {}
 
     virtual ~Building() = default;
 
+    const BuildingTypeInfo& info() const { return buildingTypeInfo(type); }
+
     // Pure virtual function for polymorphism
     virtual Resource produce() override = 0;
-    virtual std::string getProductionInfo() const override = 0;
 
-    // Common building operations
-    virtual void upgrade() {
+    std::string getProductionInfo() const override {
+        return ProductionRecord{type, level, info().outputAt(level)}.format();
+    }
+
+    // Common building operations. Returns false, leaving the level as it
+    // is, once the building is at kMaxBuildingLevel.
+    virtual bool upgrade() {
+        if(level >= kMaxBuildingLevel) return false;
         level++;
-        production["materials"] += 5;
+        return true;
     }
 
-    virtual Resource getCost() const { return cost; }
-    virtual std::string getName() const { return name; }
+    virtual const Resource& getCost() const { return info().cost; }
+    virtual std::string getName() const { return info().name; }
+    virtual BuildingType getType() const { return type; }
     virtual int getLevel() const { return level; }
     virtual bool isOperational() const { return operational; }
     virtual void setOperational(bool status) { operational = status; }
 
     // File I/O
     virtual void saveToFile(std::ofstream& file) const {
-        file << name << " " << level << " " << operational << std::endl;
+        file << info().saveKey << " " << level << " " << operational << std::endl;
     }
 
     virtual void loadFromFile(std::ifstream& file) {
-        file >> name >> level >> operational;
+        std::string key;
+        file >> key >> level >> operational;
+        if(!buildingTypeFromKey(key, type)) {
+            throw GameStateException("Unknown building type in save file: " + key);
+        }
     }
 };
 
-// Derived Building Classes demonstrating Inheritance and Polymorphism
-class SolarPanel : public Building {
+// Shared implementation of the concrete building classes. produce() reads
+// the compile-time traits of Derived and is final, so a call on a concrete
+// object (for example through std::visit) is resolved statically.
+template<typename Derived>
+class BuildingOf : public Building {
 public:
-    SolarPanel() : Building("Solar Panel") {
-        cost["materials"] = 20;
-        production["energy"] = 15;
-    }
+    using Traits = BuildingTraits<Derived>;
 
-    Resource produce() override {
-        if(!operational) return Resource();
+    BuildingOf() : Building(Traits::type) {}
+
+    Resource produce() override final {
         Resource output;
-        output["energy"] = production["energy"] * level;
+        if(!operational) return output;
+        output[Traits::output] = buildingOutput(Traits::baseRate, Traits::upgradeRate, level);
         return output;
     }
-
-    std::string getProductionInfo() const override {
-        return "Solar Panel Level " + std::to_string(level) + 
-               " produces " + std::to_string(production["energy"] * level) + " energy";
-    }
 };
 
-class Greenhouse : public Building {
+// Derived Building Classes demonstrating Inheritance and Polymorphism
+class SolarPanel final : public BuildingOf<SolarPanel> {};
+class Greenhouse final : public BuildingOf<Greenhouse> {};
+class OxygenGenerator final : public BuildingOf<OxygenGenerator> {};
+class MaterialFactory final : public BuildingOf<MaterialFactory> {};
+
+// Closed set of building types stored by value
+using BuildingVariant = std::variant<SolarPanel, Greenhouse, OxygenGenerator, MaterialFactory>;
+
+template<typename... Ts>
+BuildingVariant makeBuildingVariant(BuildingType type, BuildingList<Ts...>) {
+    BuildingVariant building;
+    ((BuildingTraits<Ts>::type == type ? (building = Ts(), true) : false) || ...);
+    return building;
+}
+
+// Alternative building storage: buildings live by value in one contiguous
+// vector and calls dispatch through std::visit instead of a vtable, with no
+// per-building heap allocation. The engine uses BuildingStore, which is
+// faster still; this layout serves callers that want whole Building objects.
+class VariantBuildingList {
+private:
+    std::vector<BuildingVariant> buildings;
+
 public:
-    Greenhouse() : Building("Greenhouse") {
-        cost["materials"] = 30;
-        cost["energy"] = 10;
-        production["food"] = 20;
+    void add(BuildingType type) {
+        buildings.push_back(makeBuildingVariant(type, AllBuildingTypes{}));
     }
 
-    Resource produce() override {
-        if(!operational) return Resource();
-        Resource output;
-        output["food"] = production["food"] * level;
-        return output;
+    void reserve(std::size_t count) { buildings.reserve(count); }
+    std::size_t size() const { return buildings.size(); }
+
+    Building& operator[](std::size_t index) {
+        return std::visit([](auto& building) -> Building& { return building; }, buildings[index]);
     }
 
-    std::string getProductionInfo() const override {
-        return "Greenhouse Level " + std::to_string(level) + 
-               " produces " + std::to_string(production["food"] * level) + " food";
+    Resource totalProduction() {
+        Resource total;
+        for(BuildingVariant& building : buildings) {
+            total += std::visit([](auto& concrete) { return concrete.produce(); }, building);
+        }
+        return total;
     }
 };
 
-class OxygenGenerator : public Building {
-public:
-    OxygenGenerator() : Building("Oxygen Generator") {
-        cost["materials"] = 25;
-        cost["energy"] = 15;
-        production["oxygen"] = 10;
-    }
+// Structure-of-arrays building storage used by the engine. Type, level and
+// operational state live in parallel arrays so totalProduction() can stream
+// through them in one pass with no pointer chasing or virtual calls.
+// BuildingView exposes the Building API over one slot for the menus.
+class BuildingView;
 
-    Resource produce() override {
-        if(!operational) return Resource();
-        Resource output;
-        output["oxygen"] = production["oxygen"] * level;
-        return output;
+class BuildingStore {
+private:
+    std::vector<BuildingType> types;
+    std::vector<std::uint16_t> levels;
+    std::vector<std::uint8_t> operational;
+
+    // Running total of every building's output. Output only changes when a
+    // building is added, upgraded or switched on/off, so those mutations
+    // update it in O(1) and a production turn just reads it.
+    Resource production;
+
+    Resource::Quantity outputOf(std::size_t index) const {
+        return operational[index] ? buildingTypeInfo(types[index]).outputAt(levels[index]) : 0;
     }
 
-    std::string getProductionInfo() const override {
-        return "Oxygen Generator Level " + std::to_string(level) + 
-               " produces " + std::to_string(production["oxygen"] * level) + " oxygen";
+    // The delta goes through the policy like any other resource sum, so a
+    // saturating build clamps the total instead of overflowing the lane
+    void adjustProduction(std::size_t index, Resource::Quantity oldOutput) {
+        Resource delta;
+        delta[buildingTypeInfo(types[index]).output] = Resource::ArithmeticPolicy::sub(outputOf(index), oldOutput);
+        production += delta;
     }
-};
 
-class MaterialFactory : public Building {
 public:
-    MaterialFactory() : Building("Material Factory") {
-        cost["materials"] = 40;
-        cost["energy"] = 20;
-        production["materials"] = 8;
+    void add(BuildingType type, int level = 1, bool isOperational = true) {
+        types.push_back(type);
+        levels.push_back(static_cast<std::uint16_t>(level));
+        operational.push_back(isOperational);
+        adjustProduction(types.size() - 1, 0);
     }
 
-    Resource produce() override {
-        if(!operational) return Resource();
-        Resource output;
-        output["materials"] = production["materials"] * level;
-        return output;
+    void add(const Building& building) {
+        add(building.getType(), building.getLevel(), building.isOperational());
     }
 
-    std::string getProductionInfo() const override {
-        return "Material Factory Level " + std::to_string(level) + 
-               " produces " + std::to_string(production["materials"] * level) + " materials";
+    void clear() {
+        types.clear();
+        levels.clear();
+        operational.clear();
+        production = Resource();
     }
-};
-
-// Colonist Class with Skills and Specializations
-class Colonist {
-private:
-    std::string name;
-    std::string specialization;
-    int experience;
-    int health;
-    bool assigned;
-
-public:
-    Colonist(const std::string& colonistName, const std::string& spec) : 
-        name(colonistName), specialization(spec), experience(0), health(100), assigned(false) {}
 
-    // Production routine based on specialization
-    Resource work() {
-        if(health < 50) {
-            throw ColonistException(name + " is too sick to work");
-        }
+    std::size_t size() const { return types.size(); }
+    bool empty() const { return types.empty(); }
 
-        Resource output;
-        experience++;
-
-        if(specialization == "Engineer") {
-            output["materials"] = 5 + experience / 10;
-        } else if(specialization == "Scientist") {
-            output["energy"] = 3 + experience / 15;
-            output["oxygen"] = 2 + experience / 20;
-        } else if(specialization == "Farmer") {
-            output["food"] = 8 + experience / 8;
-        } else {
-            output["materials"] = 2;
-            output["food"] = 2;
-        }
+    BuildingType getType(std::size_t index) const { return types[index]; }
+    int getLevel(std::size_t index) const { return levels[index]; }
+    bool isOperational(std::size_t index) const { return operational[index] != 0; }
 
-        return output;
+    void setOperational(std::size_t index, bool status) {
+        Resource::Quantity oldOutput = outputOf(index);
+        operational[index] = status;
+        adjustProduction(index, oldOutput);
     }
 
-    void rest() {
-        health = std::min(100, health + 10);
-        assigned = false;
+    // Returns false, leaving the building as it is, once it is at
+    // kMaxBuildingLevel; the 16-bit level lane would wrap to 0
+    bool upgrade(std::size_t index) {
+        if(levels[index] >= kMaxBuildingLevel) return false;
+        Resource::Quantity oldOutput = outputOf(index);
+        levels[index]++;
+        adjustProduction(index, oldOutput);
+        return true;
     }
 
-    // Getters and setters
-    std::string getName() const { return name; }
-    std::string getSpecialization() const { return specialization; }
-    int getExperience() const { return experience; }
-    int getHealth() const { return health; }
-    bool isAssigned() const { return assigned; }
-    void setAssigned(bool status) { assigned = status; }
-    void takeDamage(int damage) { 
-        health = std::max(0, health - damage); 
-        if(health == 0) {
-            throw ColonistException(name + " has died");
+    // Incrementally maintained total output of all buildings
+    const Resource& getProduction() const { return production; }
+
+    std::size_t operationalCount(BuildingType type) const {
+        std::size_t count = 0;
+        for(std::size_t i = 0; i < size(); i++) {
+            count += types[i] == type && operational[i];
         }
+        return count;
     }
 
-    void displayInfo() const {
-        std::cout << name << " (" << specialization << ") - Health: " << health 
-                  << " Experience: " << experience << " Assigned: " << (assigned ? "Yes" : "No") << std::endl;
+    // Hands one record per operational building to the sink
+    void reportProduction(ProductionSink& sink) const {
+        for(std::size_t i = 0; i < size(); i++) {
+            if(operational[i]) {
+                sink.consume(ProductionRecord{types[i], levels[i], outputOf(i)});
+            }
+        }
     }
 
     // File I/O
     void saveToFile(std::ofstream& file) const {
-        file << name << " " << specialization << " " << experience << " " 
-             << health << " " << assigned << std::endl;
+        file << size() << std::endl;
+        for(std::size_t i = 0; i < size(); i++) {
+            file << buildingTypeInfo(types[i]).saveKey << " " << levels[i] << " "
+                 << static_cast<int>(operational[i]) << std::endl;
+        }
     }
 
+    // Throws GameStateException on a truncated record, an unknown type or
+    // a level outside [1, kMaxBuildingLevel]
     void loadFromFile(std::ifstream& file) {
-        file >> name >> specialization >> experience >> health >> assigned;
-    }
-};
-
-// Event System for Random Events
-class Event {
+        std::size_t count;
+        file >> count;
+        if(file.fail()) {
+            throw GameStateException("Missing building count in save file");
+        }
+        clear();
+        for(std::size_t i = 0; i < count; i++) {
+            std::string key;
+            int level;
+            bool isOperational;
+            file >> key >> level >> isOperational;
+            if(file.fail()) {
+                throw GameStateException("Truncated building " + std::to_string(i) + " in save file");
+            }
+            BuildingType type;
+            if(!buildingTypeFromKey(key, type)) {
+                throw GameStateException("Unknown building type in save file: " + key);
+            }
+            if(level < 1 || level > kMaxBuildingLevel) {
+                throw GameStateException("Building level out of range in save file: " + std::to_string(level));
+            }
+            add(type, level, isOperational);
+        }
+    }
+
+    BuildingView view(std::size_t index);
+
+    // Full recompute of the output, used to cross-check getProduction().
+    // A building's output is (baseRate + upgradeRate * (level - 1)) * level,
+    // so per type it is enough to sum level and level * (level - 1) over
+    // operational buildings and apply the type's rates once at the end.
+    // One branch-free masked pass is generated per BuildingTraits entry.
+    Resource totalProduction() const {
+        const std::size_t count = types.size();
+        const BuildingType* typeData = types.data();
+        const std::uint16_t* levelData = levels.data();
+        const std::uint8_t* operationalData = operational.data();
+
+        Resource total;
+        forEachBuildingType([&](auto traits) {
+            using Traits = decltype(traits);
+            std::uint64_t typeLevels = 0;
+            std::uint64_t typeUpgrades = 0;
+            for(std::size_t i = 0; i < count; i++) {
+                std::uint32_t selected = static_cast<std::uint32_t>(typeData[i] == Traits::type) & operationalData[i];
+                std::uint32_t level = levelData[i] * selected;
+                typeLevels += level;
+                typeUpgrades += level * (level - selected);
+            }
+            // The rates are compile-time constants, so this folds per type.
+            // The sum stays in 64 bits until the policy narrows it into the lane.
+            std::int64_t typeOutput = Traits::baseRate * static_cast<std::int64_t>(typeLevels) +
+                                      Traits::upgradeRate * static_cast<std::int64_t>(typeUpgrades);
+            total[Traits::output] = Resource::ArithmeticPolicy::add(total[Traits::output],
+                                                                    Resource::ArithmeticPolicy::narrow(typeOutput));
+        });
+        return total;
+    }
+};
+
+// Lightweight handle giving one BuildingStore slot the Building API
+class BuildingView {
+private:
+    BuildingStore* store;
+    std::size_t index;
+
+public:
+    BuildingView(BuildingStore& buildingStore, std::size_t slot) : store(&buildingStore), index(slot) {}
+
+    const BuildingTypeInfo& info() const { return buildingTypeInfo(getType()); }
+
+    Resource produce() const {
+        Resource output;
+        if(!isOperational()) return output;
+        output[info().output] = info().outputAt(getLevel());
+        return output;
+    }
+
+    std::string getProductionInfo() const {
+        return ProductionRecord{getType(), getLevel(), info().outputAt(getLevel())}.format();
+    }
+
+    bool upgrade() { return store->upgrade(index); }
+    const Resource& getCost() const { return info().cost; }
+    std::string getName() const { return info().name; }
+    BuildingType getType() const { return store->getType(index); }
+    int getLevel() const { return store->getLevel(index); }
+    bool isOperational() const { return store->isOperational(index); }
+    void setOperational(bool status) { store->setOperational(index, status); }
+
+    void saveToFile(std::ofstream& file) const {
+        file << info().saveKey << " " << getLevel() << " " << isOperational() << std::endl;
+    }
+};
+
+inline BuildingView BuildingStore::view(std::size_t index) {
+    return BuildingView(*this, index);
+}
+
+enum class Specialization : std::uint8_t {
+    Engineer,
+    Scientist,
+    Farmer,
+    Generalist,     // any colonist without one of the trained roles
+    Count
+};
+
+constexpr std::size_t kSpecializationCount = static_cast<std::size_t>(Specialization::Count);
+
+// Work output formula for one resource: base + experience / divisor, where
+// a divisor of 0 means the yield does not grow with experience
+struct WorkYield {
+    Resource::Quantity base;
+    int divisor;
+};
+
+struct SpecializationInfo {
+    const char* name;
+    std::array<WorkYield, kBuiltinResourceCount> yields;    // indexed by ResourceType
+};
+
+// Per-specialization work formulas, indexed by Specialization; yields are
+// listed in ResourceType order (energy, food, materials, oxygen)
+constexpr std::array<SpecializationInfo, kSpecializationCount> kSpecializationTable = {{
+    { "Engineer",   {{ {0, 0}, {0, 0}, {5, 10}, {0, 0} }} },
+    { "Scientist",  {{ {3, 15}, {0, 0}, {0, 0}, {2, 20} }} },
+    { "Farmer",     {{ {0, 0}, {8, 8}, {0, 0}, {0, 0} }} },
+    { "Generalist", {{ {0, 0}, {2, 0}, {2, 0}, {0, 0} }} },
+}};
+
+constexpr const SpecializationInfo& specializationInfo(Specialization spec) {
+    return kSpecializationTable[static_cast<std::size_t>(spec)];
+}
+
+// Unknown names map to Generalist, matching the old catch-all branch
+Specialization specializationFromName(const std::string& name) {
+    for(std::size_t i = 0; i < kSpecializationCount; i++) {
+        if(name == kSpecializationTable[i].name) {
+            return static_cast<Specialization>(i);
+        }
+    }
+    return Specialization::Generalist;
+}
+
+// One colonist's free-work yield per built-in resource, the unit the
+// colonist pool caches
+using WorkOutput = std::array<int, kBuiltinResourceCount>;
+
+// Yields of one colonist with the given (already incremented) experience
+WorkOutput specializationYields(Specialization spec, int experience) {
+    WorkOutput yields;
+    const SpecializationInfo& info = specializationInfo(spec);
+    for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+        const WorkYield& yield = info.yields[r];
+        yields[r] = yield.base + (yield.divisor != 0 ? experience / yield.divisor : 0);
+    }
+    return yields;
+}
+
+// Output of one colonist with the given (already incremented) experience
+Resource specializationOutput(Specialization spec, int experience) {
+    Resource output;
+    WorkOutput yields = specializationYields(spec, experience);
+    for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+        output[static_cast<ResourceId>(r)] = yields[r];
+    }
+    return output;
+}
+
+// Experience level at which one of the role's divisors next steps its
+// yields up; yields computed at the given experience hold until then
+int nextYieldBreakpoint(Specialization spec, int experience) {
+    int breakpoint = std::numeric_limits<int>::max();
+    for(const WorkYield& yield : specializationInfo(spec).yields) {
+        if(yield.divisor != 0) {
+            breakpoint = std::min(breakpoint, (experience / yield.divisor + 1) * yield.divisor);
+        }
+    }
+    return breakpoint;
+}
+
+// Cache refresh for one colonist of role Spec: the same formulas as
+// specializationYields() and nextYieldBreakpoint(), but each divisor is a
+// compile-time constant, so the divisions become multiply-shift
+template<Specialization Spec>
+void refreshWorkOutput(int experience, WorkOutput& cached, int& validUntil) {
+    constexpr const SpecializationInfo& info = specializationInfo(Spec);
+    int breakpoint = std::numeric_limits<int>::max();
+    for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+        const WorkYield yield = info.yields[r];
+        cached[r] = yield.base;
+        if(yield.divisor != 0) {
+            const int steps = experience / yield.divisor;
+            cached[r] += steps;
+            breakpoint = std::min(breakpoint, (steps + 1) * yield.divisor);
+        }
+    }
+    validUntil = breakpoint;
+}
+
+template<std::size_t... Specs>
+constexpr std::array<void (*)(int, WorkOutput&, int&), kSpecializationCount>
+makeRefreshTable(std::index_sequence<Specs...>) {
+    return {{ &refreshWorkOutput<static_cast<Specialization>(Specs)>... }};
+}
+
+// refreshWorkOutput instantiations, indexed by Specialization
+constexpr auto kRefreshWorkOutput = makeRefreshTable(std::make_index_sequence<kSpecializationCount>{});
+
+// Colonists workAll() handles per block; small enough that a block's data
+// is still in L1 when the accumulation loop reads it back
+constexpr std::size_t kWorkBlockColonists = 64;
+
+// Work kernel over structure-of-arrays colonist data. Every colonist whose
+// eligible byte is 1 gains one experience and adds its cached yields. Each
+// block is three loops: a branch-free experience bump that also notes
+// whether anyone reached outputValidUntil, a table refresh of just those
+// colonists' caches (skipped for blocks where nobody did), and the same
+// branch-free masked add for every role. The first and last vectorize.
+Resource workAll(const Specialization* specializations, int* experience, int* outputValidUntil,
+                 WorkOutput* cachedOutput, const std::uint8_t* eligible, std::size_t count) {
+    std::array<std::int64_t, kBuiltinResourceCount> sums{};
+    for(std::size_t begin = 0; begin < count; begin += kWorkBlockColonists) {
+        const std::size_t end = std::min(count, begin + kWorkBlockColonists);
+
+        int stale = 0;
+        for(std::size_t i = begin; i < end; i++) {
+            experience[i] += eligible[i];
+            stale |= experience[i] >= outputValidUntil[i];
+        }
+        if(stale != 0) {
+            for(std::size_t i = begin; i < end; i++) {
+                if(experience[i] >= outputValidUntil[i]) {
+                    kRefreshWorkOutput[static_cast<std::size_t>(specializations[i])](
+                        experience[i], cachedOutput[i], outputValidUntil[i]);
+                }
+            }
+        }
+
+        for(std::size_t i = begin; i < end; i++) {
+            const int workedMask = -static_cast<int>(eligible[i]);
+            for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+                sums[r] += workedMask & cachedOutput[i][r];
+            }
+        }
+    }
+
+    // The 64-bit sums are narrowed into the Resource by the policy
+    Resource output;
+    for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+        output[static_cast<ResourceId>(r)] = Resource::ArithmeticPolicy::narrow(sums[r]);
+    }
+    return output;
+}
+
+// Jobs offered by each operational building
+constexpr std::size_t kJobsPerBuilding = 2;
+
+// A staffed job yields base + experience / divisor units of the building's
+// output resource, with a higher base for the matching specialist.
+// Indexed by BuildingType.
+struct JobYieldInfo {
+    Specialization specialist;
+    int specialistBase;
+    int otherBase;
+    int divisor;
+};
+
+constexpr std::array<JobYieldInfo, kBuildingTypeCount> kJobYieldTable = {{
+    { Specialization::Scientist, 12, 4, 5 },    // Solar Panel
+    { Specialization::Farmer,    14, 4, 5 },    // Greenhouse
+    { Specialization::Scientist, 10, 4, 5 },    // Oxygen Generator
+    { Specialization::Engineer,  12, 4, 5 },    // Material Factory
+}};
+
+constexpr int jobYield(BuildingType type, Specialization spec, int experience) {
+    const JobYieldInfo& info = kJobYieldTable[static_cast<std::size_t>(type)];
+    return (spec == info.specialist ? info.specialistBase : info.otherBase) + experience / info.divisor;
+}
+
+// Total units a colonist produces working freely rather than in a job
+Resource::Quantity freeWorkYield(Specialization spec, int experience) {
+    Resource output = specializationOutput(spec, experience);
+    Resource::Quantity total = 0;
+    for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+        total += output[static_cast<ResourceId>(r)];
+    }
+    return total;
+}
+
+// Colonists need at least this much health to work
+constexpr int kWorkHealthThreshold = 50;
+
+// Full health; resting never heals past it
+constexpr int kMaxHealth = 100;
+
+// Outcome of a health change. Returned instead of thrown so a phase with
+// many casualties stays a plain loop; the dead are removed afterwards.
+enum class HealthStatus : std::uint8_t {
+    Fit,    // can work
+    Sick,   // below kWorkHealthThreshold
+    Dead
+};
+
+constexpr HealthStatus healthStatus(int health) {
+    return health <= 0 ? HealthStatus::Dead
+         : health < kWorkHealthThreshold ? HealthStatus::Sick
+         : HealthStatus::Fit;
+}
+
+// kSpreadBits[b] holds the eight bits of b as eight 0/1 bytes, lowest bit first
+constexpr std::array<std::array<std::uint8_t, 8>, 256> makeSpreadBits() {
+    std::array<std::array<std::uint8_t, 8>, 256> table{};
+    for(std::size_t b = 0; b < 256; b++) {
+        for(std::size_t bit = 0; bit < 8; bit++) {
+            table[b][bit] = static_cast<std::uint8_t>((b >> bit) & 1u);
+        }
+    }
+    return table;
+}
+constexpr auto kSpreadBits = makeSpreadBits();
+
+// Growable bitset stored as 64-bit words, so masks over many slots combine
+// a word (64 colonists) at a time
+class DynamicBitset {
+private:
+    std::vector<std::uint64_t> words;
+    std::size_t bitCount = 0;
+
+public:
+    std::size_t size() const { return bitCount; }
+    std::size_t wordCount() const { return words.size(); }
+    const std::uint64_t* data() const { return words.data(); }
+    std::uint64_t* data() { return words.data(); }
+
+    void resize(std::size_t count) {
+        bitCount = count;
+        words.resize((count + 63) / 64, 0);
+        // Keep bits past the end clear so word-wise operations can ignore them
+        if(count % 64 != 0) {
+            words.back() &= (std::uint64_t(1) << (count % 64)) - 1;
+        }
+    }
+
+    void clear() {
+        words.clear();
+        bitCount = 0;
+    }
+
+    void pushBack(bool value) {
+        resize(bitCount + 1);
+        set(bitCount - 1, value);
+    }
+
+    bool test(std::size_t index) const {
+        return (words[index / 64] >> (index % 64)) & 1u;
+    }
+
+    void set(std::size_t index, bool value) {
+        std::uint64_t bit = std::uint64_t(1) << (index % 64);
+        words[index / 64] = value ? (words[index / 64] | bit) : (words[index / 64] & ~bit);
+    }
+
+    void resetAll() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+};
+
+// 64-bit FNV-1a over raw state bytes. Used to compare simulation states,
+// e.g. serial against parallel runs, without comparing field by field.
+class StateHasher {
+private:
+    std::uint64_t hash = 14695981039346656037ull;
+
+public:
+    void addBytes(const void* data, std::size_t length) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for(std::size_t i = 0; i < length; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    template<typename T>
+    void add(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "StateHasher hashes raw bytes");
+        addBytes(&value, sizeof(value));
+    }
+
+    template<typename T>
+    void addArray(const std::vector<T>& values) {
+        add(values.size());
+        addBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    std::uint64_t value() const { return hash; }
+};
+
+// Fixed set of threads that run indexed tasks. run(count, task) calls
+// task(t) for every t in [0, count) and returns once all have finished.
+// The calling thread takes tasks too, so a pool of N threads starts N - 1.
+// Which thread runs a task is unspecified; callers that need repeatable
+// results write per-task outputs and combine them in a fixed order.
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::function<void(std::size_t)> job;
+    std::size_t taskCount = 0;
+    std::size_t nextTask = 0;
+    std::size_t pendingTasks = 0;
+    std::uint64_t generation = 0;
+    bool stopping = false;
+
+    // Claims and runs tasks of the current job until none are left
+    void runTasks() {
+        for(;;) {
+            std::size_t task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(nextTask >= taskCount) {
+                    return;
+                }
+                task = nextTask++;
+            }
+            job(task);
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--pendingTasks == 0) {
+                finished.notify_all();
+            }
+        }
+    }
+
+    void workerLoop() {
+        std::uint64_t seen = 0;
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if(stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            runTasks();
+        }
+    }
+
+public:
+    explicit WorkerPool(std::size_t threadCount) {
+        for(std::size_t i = 1; i < threadCount; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    std::size_t threadCount() const { return workers.size() + 1; }
+
+    // Tasks must not throw
+    template<typename Task>
+    void run(std::size_t count, Task&& task) {
+        if(workers.empty() || count <= 1) {
+            for(std::size_t t = 0; t < count; t++) {
+                task(t);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = [&task](std::size_t t) { task(t); };
+            taskCount = count;
+            nextTask = 0;
+            pendingTasks = count;
+            generation++;
+        }
+        wake.notify_all();
+        runTasks();
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return pendingTasks == 0; });
+        job = nullptr;
+    }
+};
+
+// Colonists per work-step chunk. A multiple of 64 so chunks cover whole
+// eligibility words. The chunking depends only on the colony size, never on
+// the thread count, which keeps parallel results identical to serial ones.
+constexpr std::size_t kWorkChunkColonists = 64 * 1024;
+
+// Structure-of-arrays colonist storage used by the engine. Specialization,
+// health and experience live in parallel arrays; assigned, sick and alive
+// are bitsets, so eligibility masks and bulk rest() are word-parallel.
+// Names are kept in their own array since only menus and saves read them.
+class ColonistPool {
+private:
+    std::vector<std::string> names;
+    std::vector<Specialization> specializations;
+    std::vector<int> experience;
+    std::vector<int> health;
+    DynamicBitset assigned;
+    DynamicBitset sick;         // health below kWorkHealthThreshold
+    DynamicBitset alive;
+    std::vector<BuildingType> jobs;     // BuildingType::Count when not staffing a job
+
+    // Free-work yields at each colonist's current experience, and the
+    // experience at which they go stale. 0 forces a recompute, so adding a
+    // colonist or changing its role only resets outputValidUntil.
+    std::vector<WorkOutput> cachedOutput;
+    std::vector<int> outputValidUntil;
+
+    // Roster indices of each specialization in ascending order, kept in
+    // step with every add, removal and role change so role queries are O(1)
+    std::array<std::vector<std::uint32_t>, kSpecializationCount> members;
+
+    // Job-solver bookkeeping. staffingIds maps a colonist to its JobAssigner
+    // id (kNoStaffingId when the solver does not track it) and staffingIndex
+    // maps back. Every change to a colonist's role, experience, health or
+    // assignment sets its staffingDirty bit, so the engine only re-syncs
+    // those; ids of removed colonists wait in retiredStaffingIds.
+    std::vector<std::uint32_t> staffingIds;
+    std::vector<std::uint32_t> staffingIndex;
+    DynamicBitset staffingDirty;
+    std::vector<std::uint32_t> retiredStaffingIds;
+
+    void markStaffingDirty(std::size_t index) {
+        staffingDirty.set(index, true);
+    }
+
+    // ORs a word mask (e.g. everyone who just worked) into staffingDirty
+    void markStaffingDirty(const std::uint64_t* mask, std::size_t wordCount) {
+        std::uint64_t* dirtyWords = staffingDirty.data();
+        for(std::size_t w = 0; w < wordCount; w++) {
+            dirtyWords[w] |= mask[w];
+        }
+    }
+
+    void markAllStaffingDirty() {
+        markStaffingDirty(alive.data(), alive.wordCount());
+    }
+
+    // Per-turn scratch for the work step, reused across turns
+    std::vector<std::uint64_t> eligibleWords;
+    std::vector<std::uint8_t> eligibleBytes;
+    std::vector<Resource> workPartials;
+
+    void refreshHealthBits(std::size_t index) {
+        sick.set(index, health[index] < kWorkHealthThreshold);
+        alive.set(index, health[index] > 0);
+    }
+
+    // Rebuilds the sick and alive bitsets from health a word at a time
+    void rebuildHealthBits() {
+        const std::size_t count = health.size();
+        const int* healthData = health.data();
+        std::uint64_t* sickWords = sick.data();
+        std::uint64_t* aliveWords = alive.data();
+        for(std::size_t w = 0; w < sick.wordCount(); w++) {
+            std::uint64_t sickWord = 0;
+            std::uint64_t aliveWord = 0;
+            std::size_t end = std::min(count, (w + 1) * 64);
+            for(std::size_t i = w * 64; i < end; i++) {
+                sickWord |= static_cast<std::uint64_t>(healthData[i] < kWorkHealthThreshold) << (i % 64);
+                aliveWord |= static_cast<std::uint64_t>(healthData[i] > 0) << (i % 64);
+            }
+            sickWords[w] = sickWord;
+            aliveWords[w] = aliveWord;
+        }
+    }
+
+public:
+    void add(const std::string& name, Specialization spec, int startingExperience = 0,
+             int startingHealth = kMaxHealth, bool isAssigned = false) {
+        members[static_cast<std::size_t>(spec)].push_back(static_cast<std::uint32_t>(names.size()));
+        names.push_back(name);
+        specializations.push_back(spec);
+        experience.push_back(startingExperience);
+        health.push_back(startingHealth);
+        assigned.pushBack(isAssigned);
+        jobs.push_back(BuildingType::Count);
+        cachedOutput.push_back(WorkOutput{});
+        outputValidUntil.push_back(0);
+        sick.pushBack(startingHealth < kWorkHealthThreshold);
+        alive.pushBack(startingHealth > 0);
+        staffingIds.push_back(kNoStaffingId);
+        staffingDirty.pushBack(true);
+    }
+
+    void clear() {
+        names.clear();
+        specializations.clear();
+        experience.clear();
+        health.clear();
+        assigned.clear();
+        jobs.clear();
+        cachedOutput.clear();
+        outputValidUntil.clear();
+        sick.clear();
+        alive.clear();
+        for(auto& list : members) {
+            list.clear();
+        }
+        staffingIds.clear();
+        staffingIndex.clear();
+        staffingDirty.clear();
+        retiredStaffingIds.clear();
+    }
+
+    std::size_t size() const { return names.size(); }
+    bool empty() const { return names.empty(); }
+
+    // Per-colonist accessors for menus and events
+    const std::string& getName(std::size_t index) const { return names[index]; }
+    Specialization getSpecialization(std::size_t index) const { return specializations[index]; }
+
+    // Moves a colonist to another role; O(members of the two roles)
+    void setSpecialization(std::size_t index, Specialization spec) {
+        if(specializations[index] == spec) return;
+        std::vector<std::uint32_t>& from = members[static_cast<std::size_t>(specializations[index])];
+        std::vector<std::uint32_t>& to = members[static_cast<std::size_t>(spec)];
+        std::uint32_t id = static_cast<std::uint32_t>(index);
+        from.erase(std::lower_bound(from.begin(), from.end(), id));
+        to.insert(std::lower_bound(to.begin(), to.end(), id), id);
+        specializations[index] = spec;
+        outputValidUntil[index] = 0;
+        markStaffingDirty(index);
+    }
+
+    // Role queries. Members include colonists who died this phase until
+    // removeDead() runs.
+    std::size_t countOf(Specialization spec) const { return members[static_cast<std::size_t>(spec)].size(); }
+    bool anyOf(Specialization spec) const { return countOf(spec) != 0; }
+    // Lowest roster index with the role, or size() if there is none
+    std::size_t firstOf(Specialization spec) const {
+        const std::vector<std::uint32_t>& list = members[static_cast<std::size_t>(spec)];
+        return list.empty() ? size() : list.front();
+    }
+    const std::vector<std::uint32_t>& membersOf(Specialization spec) const {
+        return members[static_cast<std::size_t>(spec)];
+    }
+
+    int getExperience(std::size_t index) const { return experience[index]; }
+    int getHealth(std::size_t index) const { return health[index]; }
+    bool isAssigned(std::size_t index) const { return assigned.test(index); }
+    void setAssigned(std::size_t index, bool status) {
+        assigned.set(index, status);
+        jobs[index] = BuildingType::Count;
+        markStaffingDirty(index);
+    }
+
+    // Staffing a job counts as an assignment; the colonist then produces the
+    // job's yield instead of working freely
+    bool hasJob(std::size_t index) const { return jobs[index] != BuildingType::Count; }
+    BuildingType getJob(std::size_t index) const { return jobs[index]; }
+    void setJob(std::size_t index, BuildingType type) {
+        assigned.set(index, true);
+        jobs[index] = type;
+        markStaffingDirty(index);
+    }
+
+    HealthStatus getHealthStatus(std::size_t index) const { return healthStatus(health[index]); }
+
+    // Dead colonists stay in the pool, excluded from work, until removeDead()
+    HealthStatus takeDamage(std::size_t index, int damage) {
+        health[index] = std::max(0, health[index] - damage);
+        refreshHealthBits(index);
+        markStaffingDirty(index);
+        return healthStatus(health[index]);
+    }
+
+    // Damages everyone in one vectorized pass; returns how many are now dead
+    std::size_t damageAll(int damage) {
+        const std::size_t count = health.size();
+        int* healthData = health.data();
+        for(std::size_t i = 0; i < count; i++) {
+            healthData[i] = std::max(0, healthData[i] - damage);
+        }
+        rebuildHealthBits();
+        markStaffingDirty(sick.data(), sick.wordCount());
+        return deadCount();
+    }
+
+    std::size_t deadCount() const {
+        std::size_t living = 0;
+        for(std::size_t w = 0; w < alive.wordCount(); w++) {
+            living += static_cast<std::size_t>(__builtin_popcountll(alive.data()[w]));
+        }
+        return size() - living;
+    }
+
+    // Removes dead colonists in one stable compaction pass over every array,
+    // calling onRemoved(name) for each, and returns how many were removed.
+    // Invalidates indices and the eligibility mask.
+    template<typename Visitor>
+    std::size_t removeDead(Visitor&& onRemoved) {
+        const std::size_t dead = deadCount();
+        if(dead == 0) {
+            return 0;
+        }
+        for(auto& list : members) {
+            list.clear();
+        }
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < size(); i++) {
+            if(!alive.test(i)) {
+                onRemoved(names[i]);
+                if(staffingIds[i] != kNoStaffingId) {
+                    retiredStaffingIds.push_back(staffingIds[i]);
+                    staffingIndex[staffingIds[i]] = kNoStaffingId;
+                }
+                continue;
+            }
+            members[static_cast<std::size_t>(specializations[i])].push_back(static_cast<std::uint32_t>(kept));
+            if(staffingIds[i] != kNoStaffingId) {
+                staffingIndex[staffingIds[i]] = static_cast<std::uint32_t>(kept);
+            }
+            if(kept != i) {
+                names[kept] = std::move(names[i]);
+                specializations[kept] = specializations[i];
+                experience[kept] = experience[i];
+                health[kept] = health[i];
+                assigned.set(kept, assigned.test(i));
+                jobs[kept] = jobs[i];
+                cachedOutput[kept] = cachedOutput[i];
+                outputValidUntil[kept] = outputValidUntil[i];
+                sick.set(kept, sick.test(i));
+                alive.set(kept, true);
+                staffingIds[kept] = staffingIds[i];
+                staffingDirty.set(kept, staffingDirty.test(i));
+            }
+            kept++;
+        }
+        names.resize(kept);
+        specializations.resize(kept);
+        experience.resize(kept);
+        health.resize(kept);
+        assigned.resize(kept);
+        jobs.resize(kept);
+        cachedOutput.resize(kept);
+        outputValidUntil.resize(kept);
+        sick.resize(kept);
+        alive.resize(kept);
+        staffingIds.resize(kept);
+        staffingDirty.resize(kept);
+        return dead;
+    }
+
+    // Rests everyone alive: +10 health up to 100 and all assignments
+    // cleared. The health pass vectorizes and the bitsets are rebuilt a word
+    // at a time.
+    void restAll() {
+        const std::size_t count = health.size();
+        int* healthData = health.data();
+        for(std::size_t i = 0; i < count; i++) {
+            healthData[i] = healthData[i] > 0 ? std::min(kMaxHealth, healthData[i] + 10) : 0;
+        }
+        assigned.resetAll();
+        std::fill(jobs.begin(), jobs.end(), BuildingType::Count);
+        rebuildHealthBits();
+        markAllStaffingDirty();
+    }
+
+    // Computes alive & ~assigned & ~sick a word at a time into
+    // eligibleWords and returns the number of eligible colonists
+    std::size_t updateEligible() {
+        const std::size_t wordCount = alive.wordCount();
+        eligibleWords.resize(wordCount);
+        const std::uint64_t* aliveWords = alive.data();
+        const std::uint64_t* assignedWords = assigned.data();
+        const std::uint64_t* sickWords = sick.data();
+        std::size_t eligibleCount = 0;
+        for(std::size_t w = 0; w < wordCount; w++) {
+            eligibleWords[w] = aliveWords[w] & ~assignedWords[w] & ~sickWords[w];
+            eligibleCount += static_cast<std::size_t>(__builtin_popcountll(eligibleWords[w]));
+        }
+        return eligibleCount;
+    }
+
+    // Calls visit(index) for each colonist picked by the last updateEligible()
+    template<typename Visitor>
+    void forEachEligible(Visitor&& visit) const {
+        for(std::size_t w = 0; w < eligibleWords.size(); w++) {
+            std::uint64_t word = eligibleWords[w];
+            while(word != 0) {
+                visit(w * 64 + static_cast<std::size_t>(__builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    // Works every colonist picked by the last updateEligible() and returns
+    // their combined output. The colony is cut into kWorkChunkColonists
+    // chunks; each expands its slice of the mask to one byte per colonist
+    // and runs the cached workAll() kernel into its own partial Resource.
+    // Experience writes of different chunks never overlap. Partials are then
+    // summed by a fixed-shape pairwise tree, so the result is bit-identical
+    // whether chunks ran on one thread (workers == nullptr) or many.
+    Resource workEligible(WorkerPool* workers = nullptr) {
+        const std::size_t count = size();
+        const std::size_t chunkCount = (count + kWorkChunkColonists - 1) / kWorkChunkColonists;
+        eligibleBytes.resize(eligibleWords.size() * 64);
+        workPartials.assign(chunkCount, Resource());
+
+        auto workChunk = [&](std::size_t chunk) {
+            const std::size_t begin = chunk * kWorkChunkColonists;
+            const std::size_t end = std::min(count, begin + kWorkChunkColonists);
+            // Expand eight mask bits at a time into eight 0/1 bytes
+            std::uint8_t* bytes = eligibleBytes.data() + begin;
+            for(std::size_t w = begin / 64; w < (end + 63) / 64; w++) {
+                for(int shift = 0; shift < 64; shift += 8) {
+                    std::memcpy(bytes, kSpreadBits[(eligibleWords[w] >> shift) & 0xFFu].data(), 8);
+                    bytes += 8;
+                }
+            }
+            workPartials[chunk] = workAll(specializations.data() + begin, experience.data() + begin,
+                                          outputValidUntil.data() + begin, cachedOutput.data() + begin,
+                                          eligibleBytes.data() + begin, end - begin);
+        };
+        if(workers != nullptr) {
+            workers->run(chunkCount, workChunk);
+        } else {
+            for(std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+                workChunk(chunk);
+            }
+        }
+#ifdef HOMESTEAD_VERIFY_AGGREGATE
+        forEachEligible([&](std::size_t i) {
+            if(cachedOutput[i] != specializationYields(specializations[i], experience[i])) {
+                verifyFailed("cached output of " + names[i] + " is stale");
+            }
+        });
+#endif
+
+        markStaffingDirty(eligibleWords.data(), eligibleWords.size());
+
+        for(std::size_t stride = 1; stride < chunkCount; stride *= 2) {
+            for(std::size_t i = 0; i + stride < chunkCount; i += 2 * stride) {
+                workPartials[i] += workPartials[i + stride];
+            }
+        }
+        return chunkCount == 0 ? Resource() : workPartials[0];
+    }
+
+    // Calls visit(index) for each fit colonist staffing a job
+    template<typename Visitor>
+    void forEachStaffed(Visitor&& visit) const {
+        for(std::size_t w = 0; w < assigned.wordCount(); w++) {
+            std::uint64_t word = assigned.data()[w] & alive.data()[w] & ~sick.data()[w];
+            while(word != 0) {
+                std::size_t index = w * 64 + static_cast<std::size_t>(__builtin_ctzll(word));
+                if(hasJob(index)) {
+                    visit(index);
+                }
+                word &= word - 1;
+            }
+        }
+    }
+
+    // Works every fit colonist staffing a job and returns the jobs' output.
+    // Yields are summed in 64 bits and narrowed into the Resource by the
+    // policy; the caller adds it to the turn's production with +=.
+    Resource workJobs() {
+        std::array<std::int64_t, kBuiltinResourceCount> yields{};
+        forEachStaffed([&](std::size_t i) {
+            experience[i]++;
+            markStaffingDirty(i);
+            yields[static_cast<std::size_t>(buildingTypeInfo(jobs[i]).output)] +=
+                jobYield(jobs[i], specializations[i], experience[i]);
+        });
+        Resource output;
+        for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+            output[static_cast<ResourceId>(r)] = Resource::ArithmeticPolicy::narrow(yields[r]);
+        }
+        return output;
+    }
+
+    // Job-solver bookkeeping for the engine; see staffingIds
+    static constexpr std::uint32_t kNoStaffingId = 0xFFFFFFFFu;
+
+    std::uint32_t getStaffingId(std::size_t index) const { return staffingIds[index]; }
+
+    void setStaffingId(std::size_t index, std::uint32_t id) {
+        if(staffingIds[index] != kNoStaffingId) {
+            staffingIndex[staffingIds[index]] = kNoStaffingId;
+        }
+        staffingIds[index] = id;
+        if(id != kNoStaffingId) {
+            if(id >= staffingIndex.size()) {
+                staffingIndex.resize(id + 1, kNoStaffingId);
+            }
+            staffingIndex[id] = static_cast<std::uint32_t>(index);
+        }
+    }
+
+    // Roster index of the colonist with the given solver id
+    std::size_t indexOfStaffingId(std::uint32_t id) const { return staffingIndex[id]; }
+
+    // Calls retired(id) for each solver id whose colonist was removed, then
+    // visit(index) for each colonist changed since the last call
+    template<typename Retired, typename Visitor>
+    void takeStaffingChanges(Retired&& retired, Visitor&& visit) {
+        for(std::uint32_t id : retiredStaffingIds) {
+            retired(id);
+        }
+        retiredStaffingIds.clear();
+        std::uint64_t* dirtyWords = staffingDirty.data();
+        for(std::size_t w = 0; w < staffingDirty.wordCount(); w++) {
+            std::uint64_t word = dirtyWords[w];
+            dirtyWords[w] = 0;
+            while(word != 0) {
+                visit(w * 64 + static_cast<std::size_t>(__builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    void hashState(StateHasher& hasher) const {
+        hasher.addArray(specializations);
+        hasher.addArray(experience);
+        hasher.addArray(health);
+        hasher.addBytes(assigned.data(), assigned.wordCount() * sizeof(std::uint64_t));
+        hasher.addArray(jobs);
+        hasher.addBytes(sick.data(), sick.wordCount() * sizeof(std::uint64_t));
+        hasher.addBytes(alive.data(), alive.wordCount() * sizeof(std::uint64_t));
+    }
+
+    void displayInfo(std::size_t index, std::ostream& out = std::cout) const {
+        out << names[index] << " (" << specializationInfo(specializations[index]).name << ") - Health: "
+            << health[index] << " Experience: " << experience[index]
+            << " Assigned: " << (hasJob(index) ? buildingTypeInfo(jobs[index]).name
+                                               : isAssigned(index) ? "Yes" : "No") << std::endl;
+    }
+
+    // File I/O. Each line ends with the staffed building's save key, or
+    // kNoJobKey when the colonist has no job.
+    static constexpr const char* kNoJobKey = "-";
+
+    void saveToFile(std::ofstream& file) const {
+        file << size() << std::endl;
+        for(std::size_t i = 0; i < size(); i++) {
+            file << names[i] << " " << specializationInfo(specializations[i]).name << " " << experience[i] << " " 
+                 << health[i] << " " << isAssigned(i) << " "
+                 << (hasJob(i) ? buildingTypeInfo(jobs[i]).saveKey : kNoJobKey) << std::endl;
+        }
+    }
+
+    // Whole decimal number in [min, max]; throws GameStateException
+    // naming the field otherwise
+    static int parseSavedInt(const std::string& text, int min, int max, const char* field) {
+        int value = 0;
+        const char* end = text.data() + text.size();
+        std::from_chars_result parsed = std::from_chars(text.data(), end, value);
+        if(parsed.ec != std::errc() || parsed.ptr != end || value < min || value > max) {
+            throw GameStateException(std::string("Bad ") + field + " in save file: " + text);
+        }
+        return value;
+    }
+
+    // Names may contain spaces, so each line is split from the right: the
+    // last five fields are role, experience, health, assigned flag and job.
+    // Throws GameStateException on a truncated or malformed record.
+    void loadFromFile(std::ifstream& file) {
+        std::size_t count;
+        file >> count;
+        if(file.fail()) {
+            throw GameStateException("Missing colonist count in save file");
+        }
+        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        clear();
+        for(std::size_t i = 0; i < count; i++) {
+            std::string line;
+            if(!std::getline(file, line)) {
+                throw GameStateException("Save file ends after " + std::to_string(i) + " of " +
+                                         std::to_string(count) + " colonists");
+            }
+            std::istringstream words(line);
+            std::vector<std::string> fields;
+            for(std::string word; words >> word;) {
+                fields.push_back(word);
+            }
+            if(fields.size() < 6) {
+                throw GameStateException("Malformed colonist in save file: " + line);
+            }
+            const std::size_t tail = fields.size() - 5;
+            std::string name = fields[0];
+            for(std::size_t w = 1; w < tail; w++) {
+                name += " " + fields[w];
+            }
+            if(fields[tail + 3] != "0" && fields[tail + 3] != "1") {
+                throw GameStateException("Bad assigned flag in save file: " + fields[tail + 3]);
+            }
+            add(name, specializationFromName(fields[tail]),
+                parseSavedInt(fields[tail + 1], 0, std::numeric_limits<int>::max(), "experience"),
+                parseSavedInt(fields[tail + 2], 0, kMaxHealth, "health"), fields[tail + 3] == "1");
+            BuildingType job;
+            if(buildingTypeFromKey(fields[tail + 4], job)) {
+                setJob(size() - 1, job);
+            } else if(fields[tail + 4] != kNoJobKey) {
+                throw GameStateException("Unknown job in save file: " + fields[tail + 4]);
+            }
+        }
+    }
+};
+
+// Yield-maximizing assignment of colonists to building jobs. Jobs of one
+// building type are interchangeable, so the transportation problem is
+// solved on a compact graph of kBuildingTypeCount + 1 groups (one per job
+// type plus free work) instead of colonists x jobs. For every ordered pair
+// of groups (a, b) a lazy max-heap holds the colonists in a keyed by the
+// gain of moving them to b. solve() repeatedly finds the best simple
+// cycle through the groups and a virtual node standing for spare job
+// capacity, and moves the best colonist along each edge, until no cycle
+// gains anything; that is min-cost-flow cycle cancelling, so the result is
+// optimal. Each step costs a few heap operations, independent of colony
+// size. Changing a few colonists or job counts leaves the current
+// assignment in place, so the next solve() only makes the moves needed.
+class JobAssigner {
+public:
+    static constexpr std::size_t kGroupCount = kBuildingTypeCount + 1;
+    static constexpr std::size_t kFreeWork = kBuildingTypeCount;   // group of unassigned colonists
+
+private:
+    static constexpr std::uint8_t kRemoved = 0xFF;
+    static constexpr std::size_t kSpare = kGroupCount;              // virtual spare-capacity node
+    static constexpr std::size_t kNodeCount = kGroupCount + 1;
+    // Gain for pulling a colonist out of an over-full group; outweighs any
+    // real gain so overflow is always resolved first
+    static constexpr std::int64_t kEvictionBonus = std::int64_t(1) << 40;
+
+    struct HeapEntry {
+        std::int64_t gain;
+        std::uint32_t colonist;
+        std::uint32_t stamp;
+
+        bool operator<(const HeapEntry& other) const {
+            return gain != other.gain ? gain < other.gain : colonist > other.colonist;
+        }
+    };
+
+    std::vector<std::array<std::int64_t, kGroupCount>> yields;
+    std::vector<std::uint8_t> groups;
+    std::vector<std::uint32_t> stamps;      // bumped on every move; older heap entries are stale
+    std::array<std::size_t, kGroupCount> capacity{};
+    std::array<std::size_t, kGroupCount> load{};
+    std::array<std::array<std::vector<HeapEntry>, kGroupCount>, kGroupCount> heaps;
+    std::size_t heapEntries = 0;            // live and stale entries across all heaps
+    std::vector<std::uint32_t> freeIds;     // removed ids, reused by addColonist()
+    std::vector<std::uint32_t> changed;     // ids the last solve() moved
+    std::int64_t total = 0;
+
+    void pushEntries(std::uint32_t colonist) {
+        const std::size_t from = groups[colonist];
+        for(std::size_t to = 0; to < kGroupCount; to++) {
+            if(to != from) {
+                std::vector<HeapEntry>& heap = heaps[from][to];
+                heap.push_back({ yields[colonist][to] - yields[colonist][from], colonist, stamps[colonist] });
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        heapEntries += kGroupCount - 1;
+    }
+
+    // Rebuilds every heap from the live colonists once stale entries
+    // outnumber live ones three to one, so a long game of small updates
+    // does not grow the heaps without bound
+    void compactHeaps() {
+        const std::size_t live = (groups.size() - freeIds.size()) * (kGroupCount - 1);
+        if(heapEntries <= 4 * live + 1024) return;
+        for(auto& row : heaps) {
+            for(auto& heap : row) {
+                heap.clear();
+            }
+        }
+        heapEntries = 0;
+        for(std::uint32_t id = 0; id < groups.size(); id++) {
+            if(groups[id] != kRemoved) {
+                pushEntries(id);
+            }
+        }
+    }
+
+    // Best live entry of heap (from, to), dropping stale ones on the way
+    const HeapEntry* best(std::size_t from, std::size_t to) {
+        std::vector<HeapEntry>& heap = heaps[from][to];
+        while(!heap.empty()) {
+            const HeapEntry& top = heap.front();
+            if(groups[top.colonist] == from && stamps[top.colonist] == top.stamp) {
+                return &top;
+            }
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+            heapEntries--;
+        }
+        return nullptr;
+    }
+
+    void move(std::uint32_t colonist, std::size_t to) {
+        const std::size_t from = groups[colonist];
+        total += yields[colonist][to] - yields[colonist][from];
+        load[from]--;
+        load[to]++;
+        groups[colonist] = static_cast<std::uint8_t>(to);
+        stamps[colonist]++;
+        pushEntries(colonist);
+        changed.push_back(colonist);
+    }
+
+    bool hasSpace(std::size_t group) const {
+        return group == kFreeWork || load[group] < capacity[group];
+    }
+
+    // Finds the highest-weight simple cycle by exhaustive search; the graph
+    // has at most kNodeCount nodes, so this is a few hundred paths
+    void searchCycles(const std::array<std::array<std::int64_t, kNodeCount>, kNodeCount>& weight,
+                      const std::array<std::array<bool, kNodeCount>, kNodeCount>& edge,
+                      std::size_t start, std::size_t node, std::int64_t sum, std::array<std::size_t, kNodeCount>& path,
+                      std::size_t length, std::uint32_t visited,
+                      std::int64_t& bestSum, std::array<std::size_t, kNodeCount>& bestPath, std::size_t& bestLength) const {
+        if(length > 1 && edge[node][start] && sum + weight[node][start] > bestSum) {
+            bestSum = sum + weight[node][start];
+            bestPath = path;
+            bestLength = length;
+        }
+        for(std::size_t next = start + 1; length < kNodeCount && next < kNodeCount; next++) {
+            if(edge[node][next] && !(visited & (1u << next))) {
+                path[length] = next;
+                searchCycles(weight, edge, start, next, sum + weight[node][next], path, length + 1,
+                             visited | (1u << next), bestSum, bestPath, bestLength);
+            }
+        }
+    }
+
+    // Applies the best improving cycle; false once none gains anything
+    bool improve() {
+        std::array<std::array<std::int64_t, kNodeCount>, kNodeCount> weight{};
+        std::array<std::array<bool, kNodeCount>, kNodeCount> edge{};
+        std::array<std::array<std::uint32_t, kGroupCount>, kGroupCount> mover{};
+        for(std::size_t from = 0; from < kGroupCount; from++) {
+            for(std::size_t to = 0; to < kGroupCount; to++) {
+                const HeapEntry* entry = from != to ? best(from, to) : nullptr;
+                if(entry != nullptr) {
+                    edge[from][to] = true;
+                    weight[from][to] = entry->gain;
+                    mover[from][to] = entry->colonist;
+                }
+            }
+            // Spare -> group takes a colonist out of it; group -> spare fills a free job
+            edge[kSpare][from] = load[from] > 0;
+            weight[kSpare][from] = hasSpace(from) || load[from] == capacity[from] ? 0 : kEvictionBonus;
+            edge[from][kSpare] = hasSpace(from);
+        }
+
+        std::int64_t bestSum = 0;
+        std::array<std::size_t, kNodeCount> path{};
+        std::array<std::size_t, kNodeCount> bestPath{};
+        std::size_t bestLength = 0;
+        for(std::size_t start = 0; start < kNodeCount; start++) {
+            path[0] = start;
+            searchCycles(weight, edge, start, start, 0, path, 1, 1u << start, bestSum, bestPath, bestLength);
+        }
+        if(bestLength == 0) {
+            return false;
+        }
+
+        // Pick every mover before moving anyone, since moves push new entries
+        std::array<std::uint32_t, kNodeCount> movers{};
+        std::array<std::size_t, kNodeCount> targets{};
+        std::size_t moveCount = 0;
+        for(std::size_t i = 0; i < bestLength; i++) {
+            std::size_t from = bestPath[i];
+            std::size_t to = bestPath[(i + 1) % bestLength];
+            if(from != kSpare && to != kSpare) {
+                movers[moveCount] = mover[from][to];
+                targets[moveCount++] = to;
+            }
+        }
+        for(std::size_t i = 0; i < moveCount; i++) {
+            move(movers[i], targets[i]);
+        }
+        return true;
+    }
+
+public:
+    void clear() {
+        yields.clear();
+        groups.clear();
+        stamps.clear();
+        capacity.fill(0);
+        load.fill(0);
+        for(auto& row : heaps) {
+            for(auto& heap : row) {
+                heap.clear();
+            }
+        }
+        heapEntries = 0;
+        freeIds.clear();
+        changed.clear();
+        total = 0;
+    }
+
+    std::size_t size() const { return groups.size(); }
+
+    // Adds a colonist doing free work and returns its id. Ids are dense and
+    // stay valid until the colonist is removed or clear() is called; a
+    // removed colonist's id is handed out again.
+    std::size_t addColonist(Specialization spec, int experience) {
+        std::uint32_t id;
+        if(!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+            groups[id] = static_cast<std::uint8_t>(kFreeWork);
+            stamps[id]++;
+        } else {
+            id = static_cast<std::uint32_t>(groups.size());
+            yields.emplace_back();
+            groups.push_back(static_cast<std::uint8_t>(kFreeWork));
+            stamps.push_back(0);
+        }
+        load[kFreeWork]++;
+        setYields(id, spec, experience);
+        total += yields[id][kFreeWork];
+        pushEntries(id);
+        return id;
+    }
+
+    // New specialization or experience; the colonist keeps its job until
+    // the next solve() finds something better. Most experience gains do not
+    // change any yield and cost nothing.
+    void updateColonist(std::size_t id, Specialization spec, int experience) {
+        if(groups[id] == kRemoved) return;
+        std::array<std::int64_t, kGroupCount> previous = yields[id];
+        setYields(id, spec, experience);
+        if(yields[id] == previous) return;
+        total += yields[id][groups[id]] - previous[groups[id]];
+        stamps[id]++;
+        pushEntries(static_cast<std::uint32_t>(id));
+    }
+
+    void removeColonist(std::size_t id) {
+        if(groups[id] == kRemoved) return;
+        total -= yields[id][groups[id]];
+        load[groups[id]]--;
+        groups[id] = kRemoved;
+        stamps[id]++;
+        freeIds.push_back(static_cast<std::uint32_t>(id));
+    }
+
+    // Puts a colonist in a job (BuildingType::Count for free work) without
+    // solving, e.g. to match staffing loaded from a save. A job past its
+    // capacity is evicted from by the next solve().
+    void placeColonist(std::size_t id, BuildingType job) {
+        const std::size_t group = job < BuildingType::Count ? static_cast<std::size_t>(job) : kFreeWork;
+        if(groups[id] != kRemoved && groups[id] != group) {
+            move(static_cast<std::uint32_t>(id), group);
+        }
+    }
+
+    void setJobCount(BuildingType type, std::size_t jobs) {
+        capacity[static_cast<std::size_t>(type)] = jobs;
+    }
+
+    // Solves from the current assignment and returns the total yield
+    std::int64_t solve() {
+        compactHeaps();
+        changed.clear();
+        while(improve()) {}
+        return total;
+    }
+
+    // Ids the last solve() moved, possibly repeated; everyone else kept
+    // their job
+    const std::vector<std::uint32_t>& changedColonists() const { return changed; }
+
+    std::int64_t totalYield() const { return total; }
+
+    bool hasJob(std::size_t id) const { return groups[id] < kBuildingTypeCount; }
+    BuildingType getJob(std::size_t id) const { return static_cast<BuildingType>(groups[id]); }
+
+private:
+    // Yields use experience + 1 since working adds experience first
+    void setYields(std::size_t id, Specialization spec, int experience) {
+        for(std::size_t t = 0; t < kBuildingTypeCount; t++) {
+            yields[id][t] = jobYield(static_cast<BuildingType>(t), spec, experience + 1);
+        }
+        yields[id][kFreeWork] = freeWorkYield(spec, experience + 1);
+    }
+};
+
+// Random number generation. Every generator here is a standard
+// UniformRandomBitGenerator with 64-bit output, and uniformBelow() replaces
+// std::uniform_int_distribution (whose algorithm differs between standard
+// libraries), so a given seed gives bit-identical rolls on every platform.
+
+// SplitMix64: expands one 64-bit value into well-mixed seed material
+class SplitMix64 {
+private:
+    std::uint64_t state;
+
+public:
+    explicit SplitMix64(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t operator()() {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+// xoshiro256++ (Blackman and Vigna): 32 bytes of state, a few cycles per
+// draw. Best for long sequential streams.
+class Xoshiro256pp {
+public:
+    using result_type = std::uint64_t;
+
+private:
+    std::array<std::uint64_t, 4> s;
+
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    explicit Xoshiro256pp(std::uint64_t seed = 0) {
+        SplitMix64 mix(seed);
+        for(auto& word : s) word = mix();
+    }
+    explicit Xoshiro256pp(const std::array<std::uint64_t, 4>& state) : s(state) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): a keyed bijection on 128-bit counters. Output block n depends only on
+// the key and n, so any draw can be computed directly, in any order or
+// thread, without generating the ones before it.
+class Philox4x32 {
+public:
+    using Block = std::array<std::uint32_t, 4>;
+    using Key = std::array<std::uint32_t, 2>;
+
+    static Block generate(Block counter, Key key) {
+        for(int round = 0; round < 10; round++) {
+            if(round > 0) {
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+            const std::uint64_t product0 = std::uint64_t(0xD2511F53u) * counter[0];
+            const std::uint64_t product1 = std::uint64_t(0xCD9E8D57u) * counter[2];
+            counter = Block{ static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                             static_cast<std::uint32_t>(product1),
+                             static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                             static_cast<std::uint32_t>(product0) };
+        }
+        return counter;
+    }
+};
+
+// What a random stream is for; part of its key
+enum class RngSubsystem : std::uint32_t {
+    Events,         // which event a turn rolls
+    Count
+};
+
+// Names one independent stream: a game's seed, which colony of a batch,
+// the turn and the subsystem drawing from it
+struct RngKey {
+    std::uint64_t seed;
+    std::uint32_t colony;
+    std::uint32_t turn;
+    RngSubsystem subsystem;
+};
+
+// Counter-based stream: draw i of a key is the i-th Philox block (two
+// 64-bit values per block), so recomputing it needs nothing but the key
+class PhiloxStream {
+public:
+    using result_type = std::uint64_t;
+
+private:
+    Philox4x32::Key key;
+    Philox4x32::Block counter;      // {block index, subsystem, turn, colony}
+    Philox4x32::Block block{};
+    bool haveHigh = false;          // second half of block not yet returned
+
+public:
+    explicit PhiloxStream(const RngKey& streamKey)
+        : key{ static_cast<std::uint32_t>(streamKey.seed), static_cast<std::uint32_t>(streamKey.seed >> 32) },
+          counter{ 0, static_cast<std::uint32_t>(streamKey.subsystem), streamKey.turn, streamKey.colony } {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        if(haveHigh) {
+            haveHigh = false;
+            return (std::uint64_t(block[3]) << 32) | block[2];
+        }
+        block = Philox4x32::generate(counter, key);
+        counter[0]++;
+        haveHigh = true;
+        return (std::uint64_t(block[1]) << 32) | block[0];
+    }
+};
+
+// Which generator backs a RandomStream
+enum class RngKind {
+    Philox,     // counter-based; the default
+    Xoshiro     // xoshiro256++ seeded from a hash of the key
+};
+
+// A keyed stream from either generator. Both are pure functions of the key,
+// so every stream can be recreated independently.
+class RandomStream {
+public:
+    using result_type = std::uint64_t;
+
+private:
+    std::variant<PhiloxStream, Xoshiro256pp> generator;
+
+    static Xoshiro256pp seedXoshiro(const RngKey& key) {
+        std::uint64_t h = SplitMix64(key.seed)();
+        h = SplitMix64(h ^ key.colony)();
+        h = SplitMix64(h ^ key.turn)();
+        h = SplitMix64(h ^ static_cast<std::uint64_t>(key.subsystem))();
+        return Xoshiro256pp(h);
+    }
+
+public:
+    RandomStream(RngKind kind, const RngKey& key)
+        : generator(kind == RngKind::Philox ? decltype(generator)(PhiloxStream(key))
+                                            : decltype(generator)(seedXoshiro(key))) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        return std::visit([](auto& g) { return g(); }, generator);
+    }
+};
+
+// Next 64 random bits from a generator with a full 32- or 64-bit range
+template<typename Generator>
+std::uint64_t nextWord64(Generator& generator) {
+    static_assert(Generator::min() == 0, "generator range must start at 0");
+    if constexpr(Generator::max() == ~std::uint64_t(0)) {
+        return generator();
+    } else {
+        static_assert(Generator::max() == 0xFFFFFFFFu, "generator must produce 32 or 64 full bits");
+        const std::uint64_t high = generator();
+        return (high << 32) | static_cast<std::uint32_t>(generator());
+    }
+}
+
+// Uniform value in [0, bound), bound > 0. Rejects the few low values that
+// would bias the modulo, so the result is exact and portable.
+template<typename Generator>
+std::uint64_t uniformBelow(Generator& generator, std::uint64_t bound) {
+    const std::uint64_t threshold = (0 - bound) % bound;
+    std::uint64_t x;
+    do {
+        x = nextWord64(generator);
+    } while(x < threshold);
+    return x % bound;
+}
+
+// Vose alias table: after an O(n) build from integer weights, draws an
+// index with probability weight / total in O(1) using two random numbers.
+// Thresholds are kept as integers scaled by n, so the probabilities are
+// exact and draws are reproducible for a given generator.
+class AliasTable {
+private:
+    std::vector<std::uint64_t> threshold;   // keep column i when coin < threshold[i]
+    std::vector<std::uint32_t> alias;
+    std::uint64_t total = 0;
+
+public:
+    void build(const std::vector<std::uint64_t>& weights) {
+        const std::size_t n = weights.size();
+        threshold.assign(n, 0);
+        alias.assign(n, 0);
+        total = 0;
+        for(std::uint64_t weight : weights) {
+            total += weight;
+        }
+        if(total == 0) {
+            threshold.clear();
+            alias.clear();
+            return;
+        }
+
+        // Column i holds weight * n in units of total / n
+        std::vector<std::uint64_t> scaled(n);
+        std::vector<std::uint32_t> small;
+        std::vector<std::uint32_t> large;
+        for(std::size_t i = 0; i < n; i++) {
+            scaled[i] = weights[i] * n;
+            (scaled[i] < total ? small : large).push_back(static_cast<std::uint32_t>(i));
+        }
+        while(!small.empty() && !large.empty()) {
+            std::uint32_t less = small.back();
+            small.pop_back();
+            std::uint32_t more = large.back();
+            threshold[less] = scaled[less];
+            alias[less] = more;
+            scaled[more] -= total - scaled[less];
+            if(scaled[more] < total) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // Whatever is left fills its column exactly
+        for(std::uint32_t i : large) {
+            threshold[i] = total;
+            alias[i] = i;
+        }
+        for(std::uint32_t i : small) {
+            threshold[i] = total;
+            alias[i] = i;
+        }
+    }
+
+    bool empty() const { return threshold.empty(); }
+    std::size_t size() const { return threshold.size(); }
+
+    template<typename Generator>
+    std::size_t sample(Generator& generator) const {
+        std::size_t i = static_cast<std::size_t>(uniformBelow(generator, threshold.size()));
+        return uniformBelow(generator, total) < threshold[i] ? i : alias[i];
+    }
+};
+
+// Hierarchical timing wheel keyed by turn number. Level k has 64 slots of
+// 64^k turns each; an entry sits at the level of the highest 6-bit group in
+// which its due turn differs from now, so insert and cancel are O(1) and
+// advancing a turn only touches the slot that is due plus, when a lower
+// wheel wraps, the one slot that cascades down. Entries due past the top
+// level (64^kLevels turns ahead) wait in an overflow list that is only
+// revisited when the top level wraps.
+template<typename Payload>
+class TimingWheel {
+public:
+    struct Handle {
+        std::uint32_t node = kNil;
+        std::uint32_t generation = 0;
+    };
+
+private:
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+    // Node::list of an entry in the slot advance() is firing, and of one
+    // cancelled from a callback before its turn came
+    static constexpr std::uint32_t kFiring = kNil - 1;
+    static constexpr std::uint32_t kCancelled = kNil - 2;
+    static constexpr std::size_t kLevels = 4;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr std::size_t kSlots = std::size_t(1) << kSlotBits;
+    static constexpr std::size_t kOverflow = kLevels * kSlots;     // list index of the overflow list
+
+    struct Node {
+        std::uint64_t due;
+        std::uint32_t prev;
+        std::uint32_t next;
+        std::uint32_t list;         // kNil when free, else a list index, kFiring or kCancelled
+        std::uint32_t generation;
+        Payload payload;
+    };
+
+    std::vector<Node> nodes;
+    std::uint32_t freeList = kNil;
+    std::array<std::uint32_t, kLevels * kSlots + 1> heads;
+    std::uint64_t now = 0;
+    std::size_t pending = 0;
+
+    std::uint32_t listFor(std::uint64_t due) const {
+        std::uint64_t diff = due ^ now;
+        for(std::size_t level = 0; level < kLevels; level++) {
+            if((diff >> (kSlotBits * (level + 1))) == 0) {
+                return static_cast<std::uint32_t>(level * kSlots + ((due >> (kSlotBits * level)) & (kSlots - 1)));
+            }
+        }
+        return static_cast<std::uint32_t>(kOverflow);
+    }
+
+    void link(std::uint32_t index) {
+        Node& node = nodes[index];
+        node.list = listFor(node.due);
+        node.prev = kNil;
+        node.next = heads[node.list];
+        if(node.next != kNil) {
+            nodes[node.next].prev = index;
+        }
+        heads[node.list] = index;
+    }
+
+    void unlink(std::uint32_t index) {
+        Node& node = nodes[index];
+        if(node.prev != kNil) {
+            nodes[node.prev].next = node.next;
+        } else {
+            heads[node.list] = node.next;
+        }
+        if(node.next != kNil) {
+            nodes[node.next].prev = node.prev;
+        }
+    }
+
+    void recycle(std::uint32_t index) {
+        Node& node = nodes[index];
+        node.list = kNil;
+        node.next = freeList;
+        freeList = index;
+    }
+
+    void release(std::uint32_t index) {
+        nodes[index].generation++;
+        pending--;
+        recycle(index);
+    }
+
+    // Re-files every entry of a list relative to the current turn
+    void cascade(std::size_t list) {
+        std::uint32_t index = heads[list];
+        heads[list] = kNil;
+        while(index != kNil) {
+            std::uint32_t next = nodes[index].next;
+            link(index);
+            index = next;
+        }
+    }
+
+public:
+    TimingWheel() {
+        heads.fill(kNil);
+    }
+
+    std::uint64_t currentTurn() const { return now; }
+    std::size_t size() const { return pending; }
+    bool empty() const { return pending == 0; }
+
+    // Schedules payload for turn due, which must be after the current turn
+    Handle insert(std::uint64_t due, const Payload& payload) {
+        std::uint32_t index;
+        if(freeList != kNil) {
+            index = freeList;
+            freeList = nodes[index].next;
+        } else {
+            index = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(Node{ 0, kNil, kNil, kNil, 0, payload });
+        }
+        Node& node = nodes[index];
+        node.due = std::max(due, now + 1);
+        node.payload = payload;
+        link(index);
+        pending++;
+        return Handle{ index, node.generation };
+    }
+
+    // Removes a pending entry; false if it already fired or was cancelled
+    bool cancel(Handle handle) {
+        if(handle.node >= nodes.size() || nodes[handle.node].generation != handle.generation ||
+           nodes[handle.node].list == kNil || nodes[handle.node].list == kCancelled) {
+            return false;
+        }
+        Node& node = nodes[handle.node];
+        if(node.list == kFiring) {
+            // advance() is walking this entry's slot; it skips and frees it
+            node.list = kCancelled;
+            node.generation++;
+            pending--;
+            return true;
+        }
+        unlink(handle.node);
+        release(handle.node);
+        return true;
+    }
+
+    // Calls visit(due, payload) for every pending entry, in no particular
+    // order
+    template<typename Visitor>
+    void forEachPending(Visitor&& visit) const {
+        for(std::uint32_t head : heads) {
+            for(std::uint32_t index = head; index != kNil; index = nodes[index].next) {
+                visit(nodes[index].due, nodes[index].payload);
+            }
+        }
+    }
+
+    // Drops every pending entry and rewinds to turn 0. Node storage is kept
+    // for reuse; handles to dropped entries no longer match.
+    void clear() {
+        heads.fill(kNil);
+        freeList = kNil;
+        for(std::size_t i = nodes.size(); i-- > 0;) {
+            Node& node = nodes[i];
+            if(node.list != kNil && node.list != kCancelled) {
+                node.list = kNil;
+                node.generation++;
+            }
+            node.next = freeList;
+            freeList = static_cast<std::uint32_t>(i);
+        }
+        now = 0;
+        pending = 0;
+    }
+
+    // Steps turn by turn up to turn, calling fire(payload) for every entry
+    // as it comes due. fire may insert new entries and cancel pending ones,
+    // including others due the same turn.
+    template<typename Visitor>
+    void advance(std::uint64_t turn, Visitor&& fire) {
+        while(now < turn) {
+            now++;
+            // When lower wheels wrap, pull the next slot of each wrapped
+            // level down, highest level first
+            std::size_t wrapped = 0;
+            while(wrapped < kLevels && (now & ((std::uint64_t(1) << (kSlotBits * (wrapped + 1))) - 1)) == 0) {
+                wrapped++;
+            }
+            if(wrapped == kLevels) {
+                cascade(kOverflow);
+            }
+            for(std::size_t level = std::min(wrapped, kLevels - 1); level >= 1; level--) {
+                cascade(level * kSlots + ((now >> (kSlotBits * level)) & (kSlots - 1)));
+            }
+
+            // Detach the due slot and mark its entries so a cancel() from
+            // a callback flags them instead of unlinking from this walk
+            std::size_t slot = now & (kSlots - 1);
+            std::uint32_t index = heads[slot];
+            heads[slot] = kNil;
+            for(std::uint32_t i = index; i != kNil; i = nodes[i].next) {
+                nodes[i].list = kFiring;
+            }
+            while(index != kNil) {
+                std::uint32_t next = nodes[index].next;
+                if(nodes[index].list == kCancelled) {
+                    recycle(index);
+                } else {
+                    Payload payload = nodes[index].payload;
+                    release(index);
+                    fire(payload);
+                }
+                index = next;
+            }
+        }
+    }
+};
+
+// A scripted event queued for a later turn
+struct ScheduledEvent {
+    std::uint32_t event;        // index into the engine's event list
+    std::uint32_t remaining;    // runs left, including the one due
+    std::uint32_t interval;     // turns between runs
+};
+
+using EventTimers = TimingWheel<ScheduledEvent>;
+
+// Event scripts are compiled into a small register bytecode. Every
+// instruction is 8 bytes: an opcode, two small operands (registers, a
+// resource id or a specialization) and a 32-bit immediate (a constant, a
+// text index or a jump target).
+enum class EventOp : std::uint8_t {
+    Halt,
+    LoadImmediate,          // r[a] = imm
+    LoadResource,           // r[a] = resources[b]
+    LoadColonistCount,      // r[a] = colonists.size()
+    LoadHealth,             // r[a] = health of colonist r[b]
+    Increment,              // r[a]++
+    Jump,                   // pc = imm
+    JumpLess,               // if r[a] < r[b]: pc = imm
+    JumpGreaterEqual,       // if r[a] >= r[b]: pc = imm
+    JumpEqual,              // if r[a] == r[b]: pc = imm
+    JumpNotEqual,           // if r[a] != r[b]: pc = imm
+    JumpNotSpecialization,  // if colonist r[a] is not specialization b: pc = imm
+    LoadMemberCount,        // r[a] = number of colonists with specialization b
+    LoadMember,             // r[a] = roster index of member r[imm] of specialization b
+    AddResource,            // resources[b] += imm, clamped at zero
+    Damage,                 // colonist r[a] loses imm health
+    DamageAll,              // every colonist loses imm health
+    Say,                    // print texts[imm], or texts[imm] name(r[a]) texts[imm + 1]
+    Schedule,               // queue schedules[imm] on the event timers
+    Count
+};
+
+struct EventInstruction {
+    EventOp op;
+    std::uint8_t a;
+    std::uint8_t b;
+    std::int32_t imm;
+};
+
+static_assert(sizeof(EventInstruction) == 8, "event instructions should stay compact");
+
+constexpr std::size_t kEventRegisterCount = 16;
+constexpr std::uint8_t kNoRegister = 0xFF;
+
+// An after/every statement; event is resolved from eventName by linkEvents()
+struct EventSchedule {
+    std::string eventName;
+    std::uint32_t event;
+    std::uint32_t delay;
+    std::uint32_t times;
+    std::uint32_t interval;
+};
+
+// Compiled body of one event
+class EventProgram {
+private:
+    std::vector<EventInstruction> code;
+    std::vector<std::string> texts;
+    std::vector<EventSchedule> schedules;
+
+public:
+    std::size_t emit(EventOp op, std::uint8_t a = 0, std::uint8_t b = 0, std::int32_t imm = 0) {
+        code.push_back({ op, a, b, imm });
+        return code.size() - 1;
+    }
+
+    std::size_t position() const { return code.size(); }
+
+    void patch(std::size_t instruction, std::size_t target) {
+        code[instruction].imm = static_cast<std::int32_t>(target);
+    }
+
+    std::int32_t addText(const std::string& text) {
+        texts.push_back(text);
+        return static_cast<std::int32_t>(texts.size() - 1);
+    }
+
+    std::int32_t addSchedule(const EventSchedule& schedule) {
+        schedules.push_back(schedule);
+        return static_cast<std::int32_t>(schedules.size() - 1);
+    }
+
+    // Resolves scheduled event names; find(name, index) returns false for
+    // unknown names
+    template<typename Lookup>
+    void link(const std::string& owner, Lookup&& find) {
+        for(EventSchedule& schedule : schedules) {
+            if(!find(schedule.eventName, schedule.event)) {
+                throw GameStateException("event '" + owner + "' schedules unknown event '" + schedule.eventName + "'");
+            }
+        }
+    }
+
+    const std::vector<EventInstruction>& instructions() const { return code; }
+
+    // Runs the program. With GCC and Clang each handler jumps straight to
+    // the next one through a label table (threaded dispatch); elsewhere, or
+    // with -DHOMESTEAD_SWITCH_DISPATCH, a switch loop is used.
+    // Without timers, after/every statements do nothing. Messages go to out.
+    void run(Resource& resources, ColonistPool& colonists, EventTimers* timers = nullptr,
+             std::ostream& out = std::cout) const {
+        std::array<std::int64_t, kEventRegisterCount> r{};
+        const EventInstruction* ip = code.data();
+        const EventInstruction* in;
+
+#if defined(__GNUC__) && !defined(HOMESTEAD_SWITCH_DISPATCH)
+        static const void* const handlers[] = {
+            &&op_Halt, &&op_LoadImmediate, &&op_LoadResource, &&op_LoadColonistCount, &&op_LoadHealth,
+            &&op_Increment, &&op_Jump, &&op_JumpLess, &&op_JumpGreaterEqual, &&op_JumpEqual, &&op_JumpNotEqual,
+            &&op_JumpNotSpecialization, &&op_LoadMemberCount, &&op_LoadMember, &&op_AddResource,
+            &&op_Damage, &&op_DamageAll, &&op_Say, &&op_Schedule
+        };
+        static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<std::size_t>(EventOp::Count),
+                      "every EventOp needs a handler");
+#define EVENT_OP(name) op_##name:
+#define EVENT_NEXT() do { in = ip++; goto *handlers[static_cast<std::size_t>(in->op)]; } while(0)
+        EVENT_NEXT();
+#else
+#define EVENT_OP(name) case EventOp::name:
+#define EVENT_NEXT() continue
+        for(;;) {
+            in = ip++;
+            switch(in->op) {
+            case EventOp::Count:
+#endif
+        EVENT_OP(Halt)
+            return;
+        EVENT_OP(LoadImmediate)
+            r[in->a] = in->imm;
+            EVENT_NEXT();
+        EVENT_OP(LoadResource)
+            r[in->a] = resources[static_cast<ResourceId>(in->b)];
+            EVENT_NEXT();
+        EVENT_OP(LoadColonistCount)
+            r[in->a] = static_cast<std::int64_t>(colonists.size());
+            EVENT_NEXT();
+        EVENT_OP(LoadHealth)
+            r[in->a] = colonists.getHealth(static_cast<std::size_t>(r[in->b]));
+            EVENT_NEXT();
+        EVENT_OP(Increment)
+            r[in->a]++;
+            EVENT_NEXT();
+        EVENT_OP(Jump)
+            ip = code.data() + in->imm;
+            EVENT_NEXT();
+        EVENT_OP(JumpLess)
+            if(r[in->a] < r[in->b]) ip = code.data() + in->imm;
+            EVENT_NEXT();
+        EVENT_OP(JumpGreaterEqual)
+            if(r[in->a] >= r[in->b]) ip = code.data() + in->imm;
+            EVENT_NEXT();
+        EVENT_OP(JumpEqual)
+            if(r[in->a] == r[in->b]) ip = code.data() + in->imm;
+            EVENT_NEXT();
+        EVENT_OP(JumpNotEqual)
+            if(r[in->a] != r[in->b]) ip = code.data() + in->imm;
+            EVENT_NEXT();
+        EVENT_OP(JumpNotSpecialization)
+            if(colonists.getSpecialization(static_cast<std::size_t>(r[in->a])) != static_cast<Specialization>(in->b)) {
+                ip = code.data() + in->imm;
+            }
+            EVENT_NEXT();
+        EVENT_OP(LoadMemberCount)
+            r[in->a] = static_cast<std::int64_t>(colonists.countOf(static_cast<Specialization>(in->b)));
+            EVENT_NEXT();
+        EVENT_OP(LoadMember)
+            r[in->a] = colonists.membersOf(static_cast<Specialization>(in->b))[static_cast<std::size_t>(r[in->imm])];
+            EVENT_NEXT();
+        EVENT_OP(AddResource) {
+            // One lane of a clamped consume: the sum goes through the
+            // resource policy and a loss stops the stock at zero
+            Resource::Quantity& stock = resources[static_cast<ResourceId>(in->b)];
+            Resource::Quantity next = Resource::ArithmeticPolicy::add(stock, in->imm);
+            if(in->imm < 0 && next < 0) {
+                out << "Event partially failed: " << ResourceRegistry::instance().name(in->b)
+                    << " short by " << Resource::ArithmeticPolicy::sub(0, next) << std::endl;
+                next = 0;
+            }
+            stock = next;
+            EVENT_NEXT();
+        }
+        EVENT_OP(Damage)
+            colonists.takeDamage(static_cast<std::size_t>(r[in->a]), in->imm);
+            EVENT_NEXT();
+        EVENT_OP(DamageAll)
+            out << "Every colonist loses " << in->imm << " health." << std::endl;
+            colonists.damageAll(in->imm);
+            EVENT_NEXT();
+        EVENT_OP(Say)
+            out << texts[in->imm];
+            if(in->a != kNoRegister) {
+                out << colonists.getName(static_cast<std::size_t>(r[in->a])) << texts[in->imm + 1];
+            }
+            out << std::endl;
+            EVENT_NEXT();
+        EVENT_OP(Schedule)
+            if(timers != nullptr) {
+                const EventSchedule& schedule = schedules[in->imm];
+                timers->insert(timers->currentTurn() + schedule.delay,
+                               ScheduledEvent{ schedule.event, schedule.times, schedule.interval });
+            }
+            EVENT_NEXT();
+#if !defined(__GNUC__) || defined(HOMESTEAD_SWITCH_DISPATCH)
+            }
+        }
+#endif
+#undef EVENT_OP
+#undef EVENT_NEXT
+    }
+};
+
+// Event System for Random Events
+class Event {
+private:
+    std::string name;
+    std::string description;
+    int probability;
+    EventProgram program;
+
+public:
+    Event(const std::string& eventName, const std::string& desc, int prob, EventProgram eventProgram) :
+        name(eventName), description(desc), probability(prob), program(std::move(eventProgram)) {}
+
+    void execute(Resource& resources, ColonistPool& colonists, EventTimers* timers = nullptr,
+                 std::ostream& out = std::cout) const {
+        out << "Event: " << name << std::endl;
+        out << description << std::endl;
+        program.run(resources, colonists, timers, out);
+    }
+
+    int getProbability() const { return probability; }
+    std::string getName() const { return name; }
+    const EventProgram& getProgram() const { return program; }
+    EventProgram& getProgram() { return program; }
+};
+
+// Built-in events, written in the same format as events.txt:
+//
+//   event <name>                start a new event
+//   chance <percent>            probability per turn
+//   text <description>          printed when the event fires
+//   add <resource> <amount>     change a stock; losses stop at zero
+//   damage <amount>             every colonist, or the current one in a loop
+//   say <text>                  print a line; {name} is the current colonist
+//   each <filter...>            loop over matching colonists ...
+//   first <filter...>           ... or just the first match
+//   if <resource> <op> <amount> op is one of < <= > >= == !=
+//   if count <role> <op> <amount> compare how many colonists have a role
+//   after <turns> <event>       run another event <turns> turns from now
+//   every <turns> <times> <event>  run it <times> times, <turns> apart
+//   end                         close the innermost each/first/if
+//
+// Filters are a specialization name, "fit", "sick" or "any"; dead colonists
+// never match. Lines starting with # are comments. Events with chance 0
+// never fire at random and only run when scheduled.
+const char* const kDefaultEventScript = R"(
+event Solar Storm
+chance 15
+text A solar storm damages energy systems!
+add energy -30
+first Engineer
+    say {name} quickly repairs some damage!
+    add energy 10
+end
+
+event Trade Ship Arrival
+chance 25
+text A trade ship offers resources!
+add materials 20
+add food 15
+
+event Meteor Shower
+chance 10
+text Meteors provide rare materials but damage buildings!
+add materials 30
+add oxygen -10
+)";
+
+// Compiles event scripts into Events. Errors throw GameStateException
+// naming the source and line.
+class EventCompiler {
+private:
+    struct Block {
+        bool loop;
+        bool firstOnly;
+        std::uint8_t heldRegisters;         // loop: registers kept until 'end'
+        std::uint8_t positionRegister;      // loop: position in the roster or member list
+        std::uint8_t indexRegister;         // loop: roster index of the current colonist
+        std::size_t top;                    // loop: condition check
+        std::vector<std::size_t> toNext;    // loop: skip to the next colonist
+        std::vector<std::size_t> toEnd;     // jumps to just past the block
+    };
+
+    std::string source;
+    int lineNumber = 0;
+    std::vector<std::unique_ptr<Event>> events;
+
+    // Event under construction
+    bool open = false;
+    std::string name;
+    std::string description;
+    int probability = -1;
+    EventProgram program;
+    std::vector<Block> blocks;
+    std::uint8_t nextRegister = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw GameStateException(source + ":" + std::to_string(lineNumber) + ": " + message);
+    }
+
+    std::int32_t parseAmount(const std::string& token) const {
+        try {
+            std::size_t used = 0;
+            long value = std::stol(token, &used);
+            if(used == token.size() && value >= INT32_MIN && value <= INT32_MAX) {
+                return static_cast<std::int32_t>(value);
+            }
+        } catch(const std::exception&) {}
+        fail("expected a number, got '" + token + "'");
+    }
+
+    std::uint8_t parseResource(const std::string& token) const {
+        ResourceId id;
+        if(!ResourceRegistry::instance().find(token, id)) {
+            fail("unknown resource '" + token + "'");
+        }
+        return static_cast<std::uint8_t>(id);
+    }
+
+    // Two scratch registers above those held by open loops
+    std::uint8_t scratch() const {
+        if(nextRegister + std::size_t(2) > kEventRegisterCount) {
+            fail("blocks nested too deeply");
+        }
+        return nextRegister;
+    }
+
+    void finishEvent() {
+        if(!open) return;
+        if(!blocks.empty()) {
+            fail("event '" + name + "' has an unclosed block");
+        }
+        if(probability < 0) {
+            fail("event '" + name + "' has no chance");
+        }
+        program.emit(EventOp::Halt);
+        events.push_back(std::make_unique<Event>(name, description, probability, std::move(program)));
+        open = false;
+    }
+
+    void startEvent(const std::string& eventName) {
+        finishEvent();
+        if(eventName.empty()) {
+            fail("event needs a name");
+        }
+        open = true;
+        name = eventName;
+        description.clear();
+        probability = -1;
+        program = EventProgram();
+        blocks.clear();
+        nextRegister = 0;
+    }
+
+    bool findSpecialization(const std::string& token, std::uint8_t& spec) const {
+        for(std::size_t i = 0; i < kSpecializationCount; i++) {
+            if(token == kSpecializationTable[i].name) {
+                spec = static_cast<std::uint8_t>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A loop filtered by specialization walks that role's member list;
+    // otherwise it walks the whole roster
+    void openLoop(bool firstOnly, const std::vector<std::string>& filters) {
+        std::uint8_t role = kNoRegister;
+        for(const std::string& filter : filters) {
+            std::uint8_t spec;
+            if(findSpecialization(filter, spec)) {
+                role = spec;
+                break;
+            }
+        }
+
+        const bool byRole = role != kNoRegister;
+        const std::uint8_t held = byRole ? 3 : 2;
+        if(nextRegister + std::size_t(held) + 2 > kEventRegisterCount) {
+            fail("blocks nested too deeply");
+        }
+        Block block{ true, firstOnly, held, nextRegister, nextRegister, 0, {}, {} };
+        std::uint8_t count = nextRegister + 1;
+        if(byRole) {
+            block.indexRegister = nextRegister + 2;
+        }
+        std::uint8_t health = nextRegister + held;
+        std::uint8_t limit = health + 1;
+        program.emit(EventOp::LoadImmediate, block.positionRegister, 0, 0);
+        if(byRole) {
+            program.emit(EventOp::LoadMemberCount, count, role);
+        } else {
+            program.emit(EventOp::LoadColonistCount, count);
+        }
+        block.top = program.position();
+        block.toEnd.push_back(program.emit(EventOp::JumpGreaterEqual, block.positionRegister, count));
+        if(byRole) {
+            program.emit(EventOp::LoadMember, block.indexRegister, role, block.positionRegister);
+        }
+
+        // Dead colonists linger until the phase ends; never match them
+        program.emit(EventOp::LoadHealth, health, block.indexRegister);
+        program.emit(EventOp::LoadImmediate, limit, 0, 1);
+        block.toNext.push_back(program.emit(EventOp::JumpLess, health, limit));
+        for(const std::string& filter : filters) {
+            std::uint8_t spec;
+            if(filter == "any") {
+                continue;
+            } else if(filter == "fit" || filter == "sick") {
+                program.emit(EventOp::LoadImmediate, limit, 0, kWorkHealthThreshold);
+                block.toNext.push_back(program.emit(filter == "fit" ? EventOp::JumpLess : EventOp::JumpGreaterEqual,
+                                                    health, limit));
+            } else if(!findSpecialization(filter, spec)) {
+                fail("unknown colonist filter '" + filter + "'");
+            } else if(spec != role) {
+                block.toNext.push_back(program.emit(EventOp::JumpNotSpecialization, block.indexRegister, spec));
+            }
+        }
+        nextRegister += held;
+        blocks.push_back(block);
+    }
+
+    // if <resource> <op> <amount>  or  if count <specialization> <op> <amount>
+    void openIf(const std::vector<std::string>& words) {
+        const bool byRole = words.size() == 5 && words[1] == "count";
+        if(words.size() != 4 && !byRole) {
+            fail("expected: if <resource> <op> <amount> or if count <specialization> <op> <amount>");
+        }
+        std::uint8_t left = scratch();
+        std::uint8_t right = left + 1;
+        if(byRole) {
+            std::uint8_t spec;
+            if(!findSpecialization(words[2], spec)) {
+                fail("unknown specialization '" + words[2] + "'");
+            }
+            program.emit(EventOp::LoadMemberCount, left, spec);
+        } else {
+            program.emit(EventOp::LoadResource, left, parseResource(words[1]));
+        }
+        program.emit(EventOp::LoadImmediate, right, 0, parseAmount(words[words.size() - 1]));
+
+        // Jump past the block when the condition is false
+        const std::string& op = words[words.size() - 2];
+        EventOp skip;
+        bool swap = false;
+        if(op == "<") skip = EventOp::JumpGreaterEqual;
+        else if(op == ">=") skip = EventOp::JumpLess;
+        else if(op == ">") { skip = EventOp::JumpGreaterEqual; swap = true; }
+        else if(op == "<=") { skip = EventOp::JumpLess; swap = true; }
+        else if(op == "==") skip = EventOp::JumpNotEqual;
+        else if(op == "!=") skip = EventOp::JumpEqual;
+        else fail("unknown comparison '" + op + "'");
+
+        Block block{ false, false, 0, kNoRegister, kNoRegister, 0, {}, {} };
+        block.toEnd.push_back(program.emit(skip, swap ? right : left, swap ? left : right));
+        blocks.push_back(block);
+    }
+
+    void closeBlock() {
+        if(blocks.empty()) {
+            fail("'end' without an open block");
+        }
+        Block block = blocks.back();
+        blocks.pop_back();
+        if(block.loop) {
+            if(block.firstOnly) {
+                block.toEnd.push_back(program.emit(EventOp::Jump));
+            }
+            for(std::size_t jump : block.toNext) {
+                program.patch(jump, program.position());
+            }
+            program.emit(EventOp::Increment, block.positionRegister);
+            program.emit(EventOp::Jump, 0, 0, static_cast<std::int32_t>(block.top));
+            nextRegister -= block.heldRegisters;
+        }
+        for(std::size_t jump : block.toEnd) {
+            program.patch(jump, program.position());
+        }
+    }
+
+    // after <turns> <event>  or  every <turns> <times> <event>
+    void compileSchedule(bool repeating, const std::vector<std::string>& words) {
+        std::int32_t turns = parseAmount(words[1]);
+        std::int32_t times = repeating ? parseAmount(words[2]) : 1;
+        if(turns < 1 || times < 1) {
+            fail("turns and times must be at least 1");
+        }
+        std::string target;
+        for(std::size_t i = repeating ? 3 : 2; i < words.size(); i++) {
+            target += (target.empty() ? "" : " ") + words[i];
+        }
+        EventSchedule schedule{ target, 0, static_cast<std::uint32_t>(turns), static_cast<std::uint32_t>(times),
+                                static_cast<std::uint32_t>(turns) };
+        program.emit(EventOp::Schedule, 0, 0, program.addSchedule(schedule));
+    }
+
+    // Innermost loop's colonist register, or kNoRegister outside loops
+    std::uint8_t currentColonist() const {
+        for(auto block = blocks.rbegin(); block != blocks.rend(); ++block) {
+            if(block->loop) return block->indexRegister;
+        }
+        return kNoRegister;
+    }
+
+    void compileLine(const std::string& line) {
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        std::string word;
+        while(stream >> word) {
+            words.push_back(word);
+        }
+        if(words.empty() || words[0][0] == '#') {
+            return;
+        }
+
+        // Everything after the keyword, for free-text statements
+        std::size_t keywordEnd = line.find(words[0]) + words[0].size();
+        std::size_t restStart = line.find_first_not_of(" \t", keywordEnd);
+        std::string rest = restStart == std::string::npos ? "" : line.substr(restStart);
+        while(!rest.empty() && std::isspace(static_cast<unsigned char>(rest.back()))) rest.pop_back();
+
+        const std::string& keyword = words[0];
+        if(keyword == "event") {
+            startEvent(rest);
+            return;
+        }
+        if(!open) {
+            fail("'" + keyword + "' outside an event");
+        }
+        if(keyword == "chance" && words.size() == 2) {
+            probability = parseAmount(words[1]);
+            if(probability < 0 || probability > 100) {
+                fail("chance must be 0..100");
+            }
+        } else if(keyword == "text") {
+            description = rest;
+        } else if(keyword == "add" && words.size() == 3) {
+            program.emit(EventOp::AddResource, 0, parseResource(words[1]), parseAmount(words[2]));
+        } else if(keyword == "damage" && words.size() == 2) {
+            std::uint8_t colonist = currentColonist();
+            program.emit(colonist == kNoRegister ? EventOp::DamageAll : EventOp::Damage, colonist, 0,
+                         parseAmount(words[1]));
+        } else if(keyword == "say") {
+            std::size_t placeholder = rest.find("{name}");
+            if(placeholder == std::string::npos) {
+                program.emit(EventOp::Say, kNoRegister, 0, program.addText(rest));
+            } else {
+                std::uint8_t colonist = currentColonist();
+                if(colonist == kNoRegister) {
+                    fail("{name} used outside each/first");
+                }
+                std::int32_t text = program.addText(rest.substr(0, placeholder));
+                program.addText(rest.substr(placeholder + 6));
+                program.emit(EventOp::Say, colonist, 0, text);
+            }
+        } else if((keyword == "each" || keyword == "first") && words.size() >= 2) {
+            openLoop(keyword == "first", std::vector<std::string>(words.begin() + 1, words.end()));
+        } else if(keyword == "if") {
+            openIf(words);
+        } else if((keyword == "after" && words.size() >= 3) || (keyword == "every" && words.size() >= 4)) {
+            compileSchedule(keyword == "every", words);
+        } else if(keyword == "end" && words.size() == 1) {
+            closeBlock();
+        } else {
+            fail("cannot parse '" + line + "'");
+        }
+    }
+
+public:
+    std::vector<std::unique_ptr<Event>> compile(std::istream& in, const std::string& sourceName) {
+        source = sourceName;
+        lineNumber = 0;
+        events.clear();
+        open = false;
+        blocks.clear();
+        std::string line;
+        while(std::getline(in, line)) {
+            lineNumber++;
+            compileLine(line);
+        }
+        finishEvent();
+        return std::move(events);
+    }
+};
+
+// Resolves every after/every statement to an index into events
+void linkEvents(std::vector<std::unique_ptr<Event>>& events) {
+    auto find = [&](const std::string& name, std::uint32_t& index) {
+        for(std::size_t i = 0; i < events.size(); i++) {
+            if(events[i]->getName() == name) {
+                index = static_cast<std::uint32_t>(i);
+                return true;
+            }
+        }
+        return false;
+    };
+    for(auto& event : events) {
+        event->getProgram().link(event->getName(), find);
+    }
+}
+
+// Game State Management
+enum class GamePhase {
+    SETUP,
+    PRODUCTION,
+    EVENT,
+    MANAGEMENT,
+    END
+};
+
+class GameState {
 private:
-    std::string name;
-    std::string description;
-    Resource resourceEffect;
-    int probability;
+    GamePhase currentPhase;
+    int turn;
+    int colonistCount;
+    bool gameRunning;
 
 public:
-    Event(const std::string& eventName, const std::string& desc, int prob) : 
-        name(eventName), description(desc), probability(prob) {}
+    GameState() : currentPhase(GamePhase::SETUP), turn(1), colonistCount(0), gameRunning(true) {}
 
-    virtual ~Event() = default;
+    void nextPhase() {
+        switch(currentPhase) {
+            case GamePhase::SETUP:
+                currentPhase = GamePhase::PRODUCTION;
+                break;
+            case GamePhase::PRODUCTION:
+                currentPhase = GamePhase::EVENT;
+                break;
+            case GamePhase::EVENT:
+                currentPhase = GamePhase::MANAGEMENT;
+                break;
+            case GamePhase::MANAGEMENT:
+                currentPhase = GamePhase::PRODUCTION;
+                turn++;
+                break;
+            case GamePhase::END:
+                gameRunning = false;
+                break;
+        }
+    }
 
-    // Virtual function for event execution
-    virtual void execute(Resource& resources, std::vector<std::unique_ptr<Colonist>>& colonists) {
-        std::cout << "Event: " << name << std::endl;
-        std::cout << description << std::endl;
-        
-        try {
-            resources += resourceEffect;
-        } catch(const ResourceException& e) {
-            std::cout << "Event partially failed: " << e.what() << std::endl;
+    void endGame() {
+        currentPhase = GamePhase::END;
+        gameRunning = false;
+    }
+
+    // State queries
+    GamePhase getCurrentPhase() const { return currentPhase; }
+    int getTurn() const { return turn; }
+    bool isGameRunning() const { return gameRunning; }
+    int getColonistCount() const { return colonistCount; }
+    void setColonistCount(int count) { colonistCount = count; }
+
+    std::string getPhaseString() const {
+        switch(currentPhase) {
+            case GamePhase::SETUP: return "Setup";
+            case GamePhase::PRODUCTION: return "Production";
+            case GamePhase::EVENT: return "Event";
+            case GamePhase::MANAGEMENT: return "Management";
+            case GamePhase::END: return "Game Over";
+            default: return "Unknown";
+        }
+    }
+
+    // File I/O
+    void saveToFile(std::ofstream& file) const {
+        file << static_cast<int>(currentPhase) << " " << turn << " " 
+             << colonistCount << " " << gameRunning << std::endl;
+    }
+
+    // Throws GameStateException on a truncated record or an unknown phase,
+    // leaving the state unchanged
+    void loadFromFile(std::ifstream& file) {
+        int phase, loadedTurn, loadedCount;
+        bool running;
+        file >> phase >> loadedTurn >> loadedCount >> running;
+        if(file.fail()) {
+            throw GameStateException("Truncated game state in save file");
+        }
+        if(phase < static_cast<int>(GamePhase::SETUP) || phase > static_cast<int>(GamePhase::END)) {
+            throw GameStateException("Unknown game phase in save file: " + std::to_string(phase));
+        }
+        if(loadedTurn < 0 || loadedCount < 0) {
+            throw GameStateException("Negative turn or colonist count in save file");
+        }
+        currentPhase = static_cast<GamePhase>(phase);
+        turn = loadedTurn;
+        colonistCount = loadedCount;
+        gameRunning = running;
+    }
+};
+
+// Read-only view of the colony handed to whoever makes management decisions
+struct ColonyView {
+    int turn;
+    const Resource& resources;
+    const BuildingStore& buildings;
+    const ColonistPool& colonists;
+};
+
+enum class ManagementAction {
+    Build,
+    Assign,
+    Rest,
+    Save,
+    Continue,
+    Staff
+};
+
+// One management-phase choice. Out-of-range building or colonist values are
+// treated as an invalid menu pick.
+struct ManagementDecision {
+    ManagementAction action = ManagementAction::Continue;
+    BuildingType building = BuildingType::Count;    // for Build
+    std::size_t colonist = 0;                       // roster index, for Assign
+};
+
+// Makes the player's choices: console prompts in an interactive game, a
+// scripted policy in automated runs
+class PlayerController {
+public:
+    virtual ~PlayerController() = default;
+    // Shows the prompt and waits until the player is ready
+    virtual void acknowledge(const std::string& prompt) = 0;
+    virtual ManagementDecision decide(const ColonyView& colony) = 0;
+    // True if the calls above wait on a person
+    virtual bool interactive() const { return false; }
+    // Forgets anything remembered from a previous game
+    virtual void newGame() {}
+};
+
+class ConsoleController : public PlayerController {
+public:
+    bool interactive() const override { return true; }
+
+    void acknowledge(const std::string& prompt) override {
+        std::cout << prompt;
+        std::cin.get();
+    }
+
+    ManagementDecision decide(const ColonyView& colony) override {
+        std::cout << "1. Build Structure" << std::endl;
+        std::cout << "2. Assign Colonists" << std::endl;
+        std::cout << "3. Rest Colonists" << std::endl;
+        std::cout << "4. Save Game" << std::endl;
+        std::cout << "5. Continue to next turn" << std::endl;
+        std::cout << "6. Staff Buildings" << std::endl;
+        std::cout << "Choose action: ";
+
+        int choice;
+        std::cin >> choice;
+
+        ManagementDecision decision;
+        switch(choice) {
+            case 1: decision.action = ManagementAction::Build; decision.building = chooseBuilding(); break;
+            case 2: decision.action = ManagementAction::Assign; decision.colonist = chooseColonist(colony); break;
+            case 3: decision.action = ManagementAction::Rest; break;
+            case 4: decision.action = ManagementAction::Save; break;
+            case 6: decision.action = ManagementAction::Staff; break;
+            case 5:
+            default: decision.action = ManagementAction::Continue; break;
+        }
+        return decision;
+    }
+
+private:
+    BuildingType chooseBuilding() {
+        std::cout << "Available structures:" << std::endl;
+        for(std::size_t i = 0; i < kBuildingTypeCount; i++) {
+            const BuildingTypeInfo& info = buildingTypeInfo(static_cast<BuildingType>(i));
+            std::cout << i + 1 << ". " << info.name << " (" << info.costLabel << ")" << std::endl;
+        }
+
+        std::size_t choice;
+        std::cin >> choice;
+        if(choice < 1 || choice > kBuildingTypeCount) {
+            return BuildingType::Count;
+        }
+        return static_cast<BuildingType>(choice - 1);
+    }
+
+    std::size_t chooseColonist(const ColonyView& colony) {
+        std::cout << "Available colonists:" << std::endl;
+        for(std::size_t i = 0; i < colony.colonists.size(); i++) {
+            std::cout << i + 1 << ". ";
+            colony.colonists.displayInfo(i);
+        }
+
+        std::cout << "Select colonist to assign (0 to cancel): ";
+        std::size_t choice;
+        std::cin >> choice;
+        return choice > 0 && choice <= colony.colonists.size() ? choice - 1 : colony.colonists.size();
+    }
+};
+
+// Scripted policies for headless runs. They never prompt and must decide
+// from the view alone, so a seeded game replays identically.
+class IdlePolicy : public PlayerController {
+public:
+    void acknowledge(const std::string&) override {}
+    ManagementDecision decide(const ColonyView&) override { return ManagementDecision(); }
+};
+
+// Rests when anyone is sick, otherwise builds whatever produces the scarcest
+// affordable resource while keeping two turns of upkeep in stock, and staffs
+// the turn after each new building
+class GreedyPolicy : public PlayerController {
+public:
+    void acknowledge(const std::string&) override {}
+
+    ManagementDecision decide(const ColonyView& colony) override {
+        ManagementDecision decision;
+        for(std::size_t i = 0; i < colony.colonists.size(); i++) {
+            if(colony.colonists.getHealthStatus(i) == HealthStatus::Sick) {
+                decision.action = ManagementAction::Rest;
+                return decision;
+            }
+        }
+
+        if(staffPending) {
+            staffPending = false;
+            decision.action = ManagementAction::Staff;
+            return decision;
+        }
+
+        Resource reserve;
+        reserve[ResourceType::Food] = colony.colonists.size() * 3 * 2;
+        reserve[ResourceType::Oxygen] = colony.colonists.size() * 2 * 2;
+        reserve[ResourceType::Energy] = (colony.buildings.size() + 1) * 2 * 2;
+
+        for(std::size_t t = 0; t < kBuildingTypeCount; t++) {
+            BuildingType type = static_cast<BuildingType>(t);
+            const BuildingTypeInfo& info = buildingTypeInfo(type);
+            Resource needed = info.cost;
+            needed += reserve;
+            if(!colony.resources.canAfford(needed)) continue;
+            if(decision.building == BuildingType::Count
+               || colony.resources[info.output] < colony.resources[buildingTypeInfo(decision.building).output]) {
+                decision.building = type;
+            }
+        }
+        if(decision.building != BuildingType::Count) {
+            decision.action = ManagementAction::Build;
+            staffPending = true;
+        }
+        return decision;
+    }
+
+    void newGame() override { staffPending = false; }
+
+private:
+    bool staffPending = false;
+};
+
+// Policy names accepted by --policy
+std::unique_ptr<PlayerController> makePolicy(const std::string& name) {
+    if(name == "greedy") return std::make_unique<GreedyPolicy>();
+    if(name == "idle") return std::make_unique<IdlePolicy>();
+    throw GameStateException("Unknown policy '" + name + "' (expected greedy or idle)");
+}
+
+// Paces the game loop at one phase per fixed step. Deadlines advance by
+// exactly one step from the previous deadline, not from when the phase
+// finished, so time spent processing comes out of the step instead of being
+// added to it and small delays are made up on the next tick. A phase that
+// ends past its deadline is an overrun; if it is a whole step or more behind,
+// the backlog is dropped rather than run back to back. A zero step never
+// waits.
+class TickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TickScheduler(std::chrono::milliseconds step = std::chrono::milliseconds(0))
+        : step(step), deadline(Clock::now()) {}
+
+    std::chrono::milliseconds getStep() const { return step; }
+    bool throttled() const { return step.count() > 0; }
+
+    // Starts a fresh step from now, e.g. after waiting on the player
+    void restart() {
+        if(throttled()) deadline = Clock::now();
+    }
+
+    // Waits out the rest of the current step. Returns how far past its
+    // deadline the phase ran, zero if it was on time.
+    Clock::duration waitForNextTick() {
+        ticks++;
+        if(!throttled()) return Clock::duration::zero();
+        deadline += step;
+        Clock::time_point now = Clock::now();
+        if(now <= deadline) {
+            std::this_thread::sleep_until(deadline);
+            return Clock::duration::zero();
+        }
+        Clock::duration late = now - deadline;
+        overruns++;
+        worstOverrun = std::max(worstOverrun, late);
+        if(late >= step) deadline = now;
+        return late;
+    }
+
+    std::uint64_t tickCount() const { return ticks; }
+    std::uint64_t overrunCount() const { return overruns; }
+    Clock::duration getWorstOverrun() const { return worstOverrun; }
+
+    // Zeroes the tick and overrun counts, e.g. at the start of a game
+    void resetStats() {
+        ticks = 0;
+        overruns = 0;
+        worstOverrun = Clock::duration::zero();
+    }
+
+private:
+    std::chrono::milliseconds step;
+    Clock::time_point deadline;
+    std::uint64_t ticks = 0;
+    std::uint64_t overruns = 0;
+    Clock::duration worstOverrun = Clock::duration::zero();
+};
+
+// Notified by the engine at the end of each turn
+class TurnObserver {
+public:
+    virtual ~TurnObserver() = default;
+    virtual void turnEnded(int turn, const Resource& resources, std::size_t colonistCount) = 0;
+};
+
+// Seed 0 stands for "pick one from the clock"
+std::uint64_t seedOrClock(std::uint64_t seed) {
+    return seed != 0 ? seed : static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+// Command-line settings for a game session
+struct GameOptions {
+    std::size_t threads = 1;    // colonist work-step threads
+    bool headless = false;      // no console I/O; a policy plays
+    std::string policy;         // empty means the console player
+    std::uint64_t seed = 0;     // 0 seeds from the clock
+    std::uint32_t colony = 0;   // colony number within a batch; part of the random key
+    RngKind rng = RngKind::Philox;
+    std::size_t games = 1;      // headless games to run
+    int maxTurns = 0;           // 0 means no limit
+    int phaseMillis = 1000;     // wall time per phase; 0 runs unthrottled
+    std::string recordPath;     // write a replay log of the game here
+    std::string replayPath;     // replay this log instead of playing
+};
+
+// Longest accepted --phase-ms, one hour
+constexpr std::uint64_t kMaxPhaseMillis = 3600 * 1000;
+
+// Most accepted --threads: four per hardware thread, which is already well
+// past the point where more workers stop helping
+std::uint64_t maxWorkerThreads() {
+    return 4 * std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Games that neither win nor lose by this turn are cut off in headless runs
+constexpr int kHeadlessTurnLimit = 1000;
+
+// Parses a decimal option value; throws GameStateException if malformed
+std::uint64_t parseNumberOption(const std::string& flag, const std::string& value, bool allowZero) {
+    if(value.empty() || value.size() > 19
+       || !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })
+       || (!allowZero && std::stoull(value) == 0)) {
+        throw GameStateException(flag + " expects a " + (allowZero ? "" : "positive ") + "number, got '" + value + "'");
+    }
+    return std::stoull(value);
+}
+
+// Parses the options below; throws GameStateException on anything else.
+// --headless implies the greedy policy unless --policy names another, and
+// unthrottled phases unless --phase-ms is given.
+GameOptions parseGameOptions(int argc, char* argv[]) {
+    GameOptions options;
+    bool phaseSet = false;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--threads" && hasValue) {
+            std::uint64_t threads = parseNumberOption(arg, argv[++i], false);
+            if(threads > maxWorkerThreads()) {
+                throw GameStateException("--threads is limited to " + std::to_string(maxWorkerThreads()) +
+                                         " on this machine");
+            }
+            options.threads = static_cast<std::size_t>(threads);
+        } else if(arg == "--headless") {
+            options.headless = true;
+        } else if(arg == "--policy" && hasValue) {
+            options.policy = argv[++i];
+            makePolicy(options.policy);
+        } else if(arg == "--seed" && hasValue) {
+            options.seed = parseNumberOption(arg, argv[++i], true);
+        } else if(arg == "--colony" && hasValue) {
+            std::uint64_t colony = parseNumberOption(arg, argv[++i], true);
+            if(colony > 0xFFFFFFFFu) {
+                throw GameStateException("--colony is limited to 32 bits");
+            }
+            options.colony = static_cast<std::uint32_t>(colony);
+        } else if(arg == "--rng" && hasValue) {
+            std::string kind = argv[++i];
+            if(kind == "philox") {
+                options.rng = RngKind::Philox;
+            } else if(kind == "xoshiro") {
+                options.rng = RngKind::Xoshiro;
+            } else {
+                throw GameStateException("Unknown generator '" + kind + "' (expected philox or xoshiro)");
+            }
+        } else if(arg == "--record" && hasValue) {
+            options.recordPath = argv[++i];
+        } else if(arg == "--replay" && hasValue) {
+            options.replayPath = argv[++i];
+        } else if(arg == "--games" && hasValue) {
+            options.games = parseNumberOption(arg, argv[++i], false);
+        } else if(arg == "--max-turns" && hasValue) {
+            std::uint64_t turns = parseNumberOption(arg, argv[++i], false);
+            options.maxTurns = static_cast<int>(std::min<std::uint64_t>(turns, 1000000000));
+        } else if(arg == "--phase-ms" && hasValue) {
+            std::uint64_t millis = parseNumberOption(arg, argv[++i], true);
+            if(millis > kMaxPhaseMillis) {
+                throw GameStateException("--phase-ms is limited to " + std::to_string(kMaxPhaseMillis));
+            }
+            options.phaseMillis = static_cast<int>(millis);
+            phaseSet = true;
+        } else {
+            throw GameStateException("Unknown option '" + arg + "' (usage: homestead [--threads N] [--headless] "
+                                     "[--policy greedy|idle] [--seed N] [--colony N] [--rng philox|xoshiro] [--games N] "
+                                     "[--max-turns N] [--phase-ms N] [--record FILE] [--replay FILE])");
+        }
+    }
+    if(std::uint64_t(options.colony) + options.games - 1 > 0xFFFFFFFFu) {
+        throw GameStateException("--colony plus --games must stay within 32 bits");
+    }
+    if(!options.recordPath.empty() && options.games > 1) {
+        throw GameStateException("--record logs a single game; drop --games");
+    }
+    if(options.headless) {
+        if(options.policy.empty()) options.policy = "greedy";
+        if(options.maxTurns == 0) options.maxTurns = kHeadlessTurnLimit;
+        if(!phaseSet) options.phaseMillis = 0;
+    }
+    return options;
+}
+
+// How a game ended
+enum class GameOutcome {
+    Running,
+    Won,
+    OutOfResources,
+    AllPerished,
+    TurnLimit
+};
+
+const char* gameOutcomeName(GameOutcome outcome) {
+    switch(outcome) {
+        case GameOutcome::Running: return "unfinished";
+        case GameOutcome::Won: return "won";
+        case GameOutcome::OutOfResources: return "out of resources";
+        case GameOutcome::AllPerished: return "all perished";
+        case GameOutcome::TurnLimit: return "turn limit";
+    }
+    return "unknown";
+}
+
+// Replay logs: the seed and every management choice of one game, plus a
+// state hash at the end of each turn. Little-endian binary, after the
+// header a sequence of tagged records:
+//   header   "HSRL", u8 version, u8 generator, u32 colony, u64 seed, u32 turn limit
+//   decision 1, u8 action, u8 building, varint colonist
+//   turn     2, varint turn, u64 state hash
+//   end      3, u8 outcome, varint turn
+// A log without an end record is from a game that was interrupted.
+// Version 2 changed the state hash to cover every pending timer.
+constexpr char kReplayMagic[4] = { 'H', 'S', 'R', 'L' };
+constexpr std::uint8_t kReplayVersion = 2;
+
+enum class ReplayRecord : std::uint8_t {
+    Decision = 1,
+    Turn = 2,
+    End = 3
+};
+
+struct TurnHash {
+    std::uint32_t turn;
+    std::uint64_t hash;
+};
+
+// First turn whose state hash differs from the log, if any
+struct ReplayDivergence {
+    bool found = false;
+    std::uint32_t turn = 0;
+    std::uint64_t expected = 0;
+    std::uint64_t actual = 0;
+};
+
+struct ReplayLog {
+    RngKind rng = RngKind::Philox;
+    std::uint32_t colony = 0;
+    std::uint64_t seed = 0;
+    std::uint32_t maxTurns = 0;
+    std::vector<ManagementDecision> decisions;
+    std::vector<TurnHash> turns;
+    bool finished = false;      // an end record was read
+    GameOutcome outcome = GameOutcome::Running;
+    std::uint32_t finalTurn = 0;
+
+    // Reads a whole log; throws GameStateException if it is not one
+    static ReplayLog load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if(!file) {
+            throw GameStateException("Cannot open replay log " + path);
+        }
+        auto fail = [&](const std::string& why) -> GameStateException {
+            return GameStateException("Bad replay log " + path + ": " + why);
+        };
+        auto readBytes = [&](std::size_t count) {
+            std::uint64_t value = 0;
+            for(std::size_t i = 0; i < count; i++) {
+                int byte = file.get();
+                if(byte == EOF) throw fail("truncated");
+                value |= std::uint64_t(byte) << (8 * i);
+            }
+            return value;
+        };
+        auto readVarint = [&]() {
+            std::uint64_t value = 0;
+            for(unsigned shift = 0; shift < 64; shift += 7) {
+                std::uint64_t byte = readBytes(1);
+                value |= (byte & 0x7F) << shift;
+                if((byte & 0x80) == 0) return value;
+            }
+            throw fail("varint too long");
+        };
+
+        char magic[4];
+        if(!file.read(magic, 4) || std::memcmp(magic, kReplayMagic, 4) != 0) throw fail("not a replay log");
+        if(readBytes(1) != kReplayVersion) throw fail("unsupported version");
+        ReplayLog log;
+        std::uint64_t rng = readBytes(1);
+        if(rng > static_cast<std::uint64_t>(RngKind::Xoshiro)) throw fail("unknown generator");
+        log.rng = static_cast<RngKind>(rng);
+        log.colony = static_cast<std::uint32_t>(readBytes(4));
+        log.seed = readBytes(8);
+        log.maxTurns = static_cast<std::uint32_t>(readBytes(4));
+
+        int tag;
+        while(!log.finished && (tag = file.get()) != EOF) {
+            switch(static_cast<ReplayRecord>(tag)) {
+                case ReplayRecord::Decision: {
+                    ManagementDecision decision;
+                    std::uint64_t action = readBytes(1);
+                    std::uint64_t building = readBytes(1);
+                    if(action > static_cast<std::uint64_t>(ManagementAction::Staff)) throw fail("unknown action");
+                    decision.action = static_cast<ManagementAction>(action);
+                    decision.building = static_cast<BuildingType>(std::min<std::uint64_t>(building, kBuildingTypeCount));
+                    decision.colonist = static_cast<std::size_t>(readVarint());
+                    log.decisions.push_back(decision);
+                    break;
+                }
+                case ReplayRecord::Turn: {
+                    std::uint32_t turn = static_cast<std::uint32_t>(readVarint());
+                    log.turns.push_back(TurnHash{ turn, readBytes(8) });
+                    break;
+                }
+                case ReplayRecord::End: {
+                    std::uint64_t outcome = readBytes(1);
+                    if(outcome > static_cast<std::uint64_t>(GameOutcome::TurnLimit)) throw fail("unknown outcome");
+                    log.outcome = static_cast<GameOutcome>(outcome);
+                    log.finalTurn = static_cast<std::uint32_t>(readVarint());
+                    log.finished = true;
+                    break;
+                }
+                default:
+                    throw fail("unknown record " + std::to_string(tag));
+            }
         }
+        return log;
     }
+};
 
-    int getProbability() const { return probability; }
-    std::string getName() const { return name; }
+// Appends records to a log as the game runs; each turn is flushed so a
+// crashed session still leaves a usable log
+class ReplayWriter {
+private:
+    std::ofstream file;
 
-protected:
-    void setResourceEffect(const std::string& resource, int amount) {
-        resourceEffect[resource] = amount;
+    void writeBytes(std::uint64_t value, std::size_t count) {
+        for(std::size_t i = 0; i < count; i++) {
+            file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
     }
-};
 
-// Specific Event Types
-class SolarStorm : public Event {
-public:
-    SolarStorm() : Event("Solar Storm", "A solar storm damages energy systems!", 15) {
-        setResourceEffect("energy", -30);
+    void writeVarint(std::uint64_t value) {
+        while(value >= 0x80) {
+            file.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        file.put(static_cast<char>(value));
     }
 
-    void execute(Resource& resources, std::vector<std::unique_ptr<Colonist>>& colonists) override {
-        Event::execute(resources, colonists);
-        // Additional effects specific to solar storm
-        for(auto& colonist : colonists) {
-            if(colonist->getSpecialization() == "Engineer") {
-                std::cout << colonist->getName() << " quickly repairs some damage!" << std::endl;
-                resources["energy"] += 10;
-                break;
-            }
+public:
+    ReplayWriter(const std::string& path, RngKind rng, std::uint32_t colony, std::uint64_t seed, int maxTurns)
+        : file(path, std::ios::binary | std::ios::trunc) {
+        if(!file) {
+            throw GameStateException("Cannot write replay log " + path);
         }
+        file.write(kReplayMagic, 4);
+        writeBytes(kReplayVersion, 1);
+        writeBytes(static_cast<std::uint64_t>(rng), 1);
+        writeBytes(colony, 4);
+        writeBytes(seed, 8);
+        writeBytes(static_cast<std::uint32_t>(maxTurns), 4);
     }
-};
 
-class TradeShip : public Event {
-public:
-    TradeShip() : Event("Trade Ship Arrival", "A trade ship offers resources!", 25) {
-        setResourceEffect("materials", 20);
-        setResourceEffect("food", 15);
+    void decision(const ManagementDecision& decision) {
+        writeBytes(static_cast<std::uint8_t>(ReplayRecord::Decision), 1);
+        writeBytes(static_cast<std::uint64_t>(decision.action), 1);
+        writeBytes(static_cast<std::uint64_t>(decision.building), 1);
+        writeVarint(decision.colonist);
     }
-};
 
-class MeteorShower : public Event {
-public:
-    MeteorShower() : Event("Meteor Shower", "Meteors provide rare materials but damage buildings!", 10) {
-        setResourceEffect("materials", 30);
-        setResourceEffect("oxygen", -10);
+    void turn(std::uint32_t turn, std::uint64_t hash) {
+        writeBytes(static_cast<std::uint8_t>(ReplayRecord::Turn), 1);
+        writeVarint(turn);
+        writeBytes(hash, 8);
+        file.flush();
     }
-};
 
-// Game State Management
-enum class GamePhase {
-    SETUP,
-    PRODUCTION,
-    EVENT,
-    MANAGEMENT,
-    END
+    void end(GameOutcome outcome, std::uint32_t turn) {
+        writeBytes(static_cast<std::uint8_t>(ReplayRecord::End), 1);
+        writeBytes(static_cast<std::uint64_t>(outcome), 1);
+        writeVarint(turn);
+        file.flush();
+    }
 };
 
-class GameState {
+// Plays back the recorded choices in order; once they run out every
+// further turn continues without acting
+class ReplayController : public PlayerController {
 private:
-    GamePhase currentPhase;
-    int turn;
-    int colonistCount;
-    bool gameRunning;
+    const std::vector<ManagementDecision>& decisions;
+    std::size_t next = 0;
 
 public:
-    GameState() : currentPhase(GamePhase::SETUP), turn(1), colonistCount(0), gameRunning(true) {}
+    explicit ReplayController(const std::vector<ManagementDecision>& recorded) : decisions(recorded) {}
 
-    void nextPhase() {
-        switch(currentPhase) {
-            case GamePhase::SETUP:
-                currentPhase = GamePhase::PRODUCTION;
-                break;
-            case GamePhase::PRODUCTION:
-                currentPhase = GamePhase::EVENT;
-                break;
-            case GamePhase::EVENT:
-                currentPhase = GamePhase::MANAGEMENT;
-                break;
-            case GamePhase::MANAGEMENT:
-                currentPhase = GamePhase::PRODUCTION;
-                turn++;
-                break;
-            case GamePhase::END:
-                gameRunning = false;
-                break;
-        }
-    }
-
-    void endGame() {
-        currentPhase = GamePhase::END;
-        gameRunning = false;
-    }
-
-    // State queries
-    GamePhase getCurrentPhase() const { return currentPhase; }
-    int getTurn() const { return turn; }
-    bool isGameRunning() const { return gameRunning; }
-    int getColonistCount() const { return colonistCount; }
-    void setColonistCount(int count) { colonistCount = count; }
+    void acknowledge(const std::string&) override {}
 
-    std::string getPhaseString() const {
-        switch(currentPhase) {
-            case GamePhase::SETUP: return "Setup";
-            case GamePhase::PRODUCTION: return "Production";
-            case GamePhase::EVENT: return "Event";
-            case GamePhase::MANAGEMENT: return "Management";
-            case GamePhase::END: return "Game Over";
-            default: return "Unknown";
-        }
+    ManagementDecision decide(const ColonyView&) override {
+        return next < decisions.size() ? decisions[next++] : ManagementDecision();
     }
 
-    // File I/O
-    void saveToFile(std::ofstream& file) const {
-        file << static_cast<int>(currentPhase) << " " << turn << " " 
-             << colonistCount << " " << gameRunning << std::endl;
-    }
+    void newGame() override { next = 0; }
 
-    void loadFromFile(std::ifstream& file) {
-        int phase;
-        file >> phase >> turn >> colonistCount >> gameRunning;
-        currentPhase = static_cast<GamePhase>(phase);
-    }
+    std::size_t used() const { return next; }
 };
 
 // Main Game Engine Class
 class GameEngine {
 private:
     GameState gameState;
+    Resource startingResources;     // defaults plus config.txt extras
     Resource colonyResources;
-    std::vector<std::unique_ptr<Building>> buildings;
-    std::vector<std::unique_ptr<Colonist>> colonists;
+    BuildingStore buildings;
+    ColonistPool colonists;
     std::vector<std::unique_ptr<Event>> events;
-    std::mt19937 randomGenerator;
+    AliasTable eventTable;      // over events plus a final "quiet turn" entry
+    EventTimers eventTimers;    // after/every effects, keyed by turn
+    RngKind rngKind;
+    std::uint64_t seed;         // with colony, keys every random stream
+    std::uint32_t colony;
+    std::unique_ptr<ProductionSink> productionSink;
+    std::unique_ptr<WorkerPool> workerPool;     // null when single-threaded
+    JobAssigner jobAssigner;
+    std::unique_ptr<PlayerController> controller;
+    bool verbose;               // per-phase status and per-colonist reports
+    int maxTurns;               // 0 means no limit
+    TickScheduler ticks;
+    bool waitedForPlayer = false;   // this phase blocked on the controller
+    GameOutcome outcome = GameOutcome::Running;
+    TurnObserver* turnObserver = nullptr;
+    std::ostream out;               // game messages; discarded when headless
+    std::unique_ptr<ReplayWriter> recorder;             // null unless recording
+    const std::vector<TurnHash>* expectedTurns = nullptr;  // replay check
+    std::size_t checkedTurns = 0;
+    ReplayDivergence divergence;
 
     // Configuration data
     std::map<std::string, std::string> config;
 
 public:
-    GameEngine() : randomGenerator(std::chrono::steady_clock::now().time_since_epoch().count()) {
+    explicit GameEngine(const GameOptions& options = GameOptions()) : startingResources(Resource::startingStock()),
+        rngKind(options.rng), seed(seedOrClock(options.seed)), colony(options.colony), verbose(!options.headless), maxTurns(options.maxTurns),
+        ticks(std::chrono::milliseconds(options.phaseMillis)), out(verbose ? std::cout.rdbuf() : nullptr) {
+        if(verbose) {
+            productionSink = std::make_unique<ConsoleProductionSink>(out);
+        } else {
+            productionSink = std::make_unique<NullProductionSink>();
+        }
+        if(options.policy.empty()) {
+            controller = std::make_unique<ConsoleController>();
+        } else {
+            controller = makePolicy(options.policy);
+        }
+        if(options.threads > 1) {
+            workerPool = std::make_unique<WorkerPool>(options.threads);
+        }
         initializeGame();
+        if(!options.recordPath.empty()) {
+            recorder = std::make_unique<ReplayWriter>(options.recordPath, rngKind, colony, seed, maxTurns);
+        }
+    }
+
+    // Starts a new game with the given seed (0 seeds from the clock) and
+    // colony number. The configuration, compiled events and all allocated
+    // storage are kept, so a batch runner can play many games on one engine.
+    void reset(std::uint64_t gameSeed, std::uint32_t gameColony = 0) {
+        gameState = GameState();
+        buildings.clear();
+        colonists.clear();
+        eventTimers.clear();
+        jobAssigner.clear();
+        seed = seedOrClock(gameSeed);
+        colony = gameColony;
+        recorder.reset();       // a log covers only the engine's first game
+        checkedTurns = 0;
+        divergence = ReplayDivergence();
+        controller->newGame();
+        outcome = GameOutcome::Running;
+        startColony();
+    }
+
+    GameOutcome getOutcome() const { return outcome; }
+    int getTurn() const { return gameState.getTurn(); }
+    std::uint64_t getSeed() const { return seed; }
+    std::uint32_t getColony() const { return colony; }
+
+    // The stream a subsystem draws from this turn. It depends only on the
+    // seed, colony, turn and subsystem, so any roll can be recomputed.
+    RandomStream randomStream(RngSubsystem subsystem) const {
+        return RandomStream(rngKind, RngKey{ seed, colony, static_cast<std::uint32_t>(gameState.getTurn()), subsystem });
+    }
+
+    // Replaces whoever makes the player's choices
+    void setController(std::unique_ptr<PlayerController> newController) {
+        controller = std::move(newController);
+    }
+
+    // Compares the state hash after each turn with a recorded one and ends
+    // the game at the first mismatch. The hashes must outlive the game.
+    void verifyTurns(const std::vector<TurnHash>* expected) {
+        expectedTurns = expected;
+        checkedTurns = 0;
+        divergence = ReplayDivergence();
+    }
+
+    const ReplayDivergence& getDivergence() const { return divergence; }
+
+    // Hash of everything that carries over between turns
+    std::uint64_t stateHash() const {
+        StateHasher hasher;
+        hasher.add(gameState.getTurn());
+        hasher.add(colonyResources);
+        for(std::size_t i = 0; i < buildings.size(); i++) {
+            hasher.add(buildings.getType(i));
+            hasher.add(buildings.getLevel(i));
+            hasher.add(buildings.isOperational(i));
+        }
+        colonists.hashState(hasher);
+        // Timer lists depend on insertion order, so pending entries are
+        // hashed sorted
+        std::vector<std::array<std::uint64_t, 4>> timers;
+        eventTimers.forEachPending([&](std::uint64_t due, const ScheduledEvent& scheduled) {
+            timers.push_back({ due, scheduled.event, scheduled.remaining, scheduled.interval });
+        });
+        std::sort(timers.begin(), timers.end());
+        hasher.add(eventTimers.currentTurn());
+        hasher.addArray(timers);
+        return hasher.value();
+    }
+
+    // Observer notified at the end of every turn; null for none
+    void setTurnObserver(TurnObserver* observer) {
+        turnObserver = observer;
+    }
+
+    void waitForPlayer(const std::string& prompt) {
+        controller->acknowledge(prompt);
+    }
+
+    // Replaces where per-building production reports go
+    void setProductionSink(std::unique_ptr<ProductionSink> sink) {
+        productionSink = std::move(sink);
+    }
+
+    // Assigns fit colonists to building jobs (kJobsPerBuilding per
+    // operational building) so the colony's total yield is maximal, and
+    // returns that yield. Colonists left out go back to free work. The
+    // solver keeps its state between calls: only colonists that changed
+    // since the last staffing are re-synced, and the solve starts from the
+    // current assignment. Colonists the player assigned by hand stay put.
+    std::int64_t staffBuildings() {
+        for(std::size_t t = 0; t < kBuildingTypeCount; t++) {
+            BuildingType type = static_cast<BuildingType>(t);
+            jobAssigner.setJobCount(type, kJobsPerBuilding * buildings.operationalCount(type));
+        }
+        syncJobAssigner();
+        std::int64_t yield = jobAssigner.solve();
+#ifdef HOMESTEAD_VERIFY_AGGREGATE
+        JobAssigner fresh;
+        for(std::size_t t = 0; t < kBuildingTypeCount; t++) {
+            BuildingType type = static_cast<BuildingType>(t);
+            fresh.setJobCount(type, kJobsPerBuilding * buildings.operationalCount(type));
+        }
+        for(std::size_t i = 0; i < colonists.size(); i++) {
+            if(colonists.getStaffingId(i) != ColonistPool::kNoStaffingId) {
+                fresh.addColonist(colonists.getSpecialization(i), colonists.getExperience(i));
+            }
+        }
+        if(fresh.solve() != yield) {
+            verifyFailed("incremental job assignment is not optimal");
+        }
+#endif
+        for(std::uint32_t id : jobAssigner.changedColonists()) {
+            std::size_t index = colonists.indexOfStaffingId(id);
+            if(jobAssigner.hasJob(id)) {
+                colonists.setJob(index, jobAssigner.getJob(id));
+            } else if(colonists.hasJob(index)) {
+                colonists.setAssigned(index, false);
+            }
+        }
+        return yield;
+    }
+
+    // Feeds the job solver every colonist change since the last sync. Fit
+    // colonists are tracked unless hand-assigned to free work; an unfit one
+    // leaves the solver and its job.
+    void syncJobAssigner() {
+        colonists.takeStaffingChanges(
+            [&](std::uint32_t id) { jobAssigner.removeColonist(id); },
+            [&](std::size_t i) {
+                std::uint32_t id = colonists.getStaffingId(i);
+                bool fit = colonists.getHealthStatus(i) == HealthStatus::Fit;
+                bool handAssigned = colonists.isAssigned(i) && !colonists.hasJob(i);
+                if(!fit || handAssigned) {
+                    if(id != ColonistPool::kNoStaffingId) {
+                        jobAssigner.removeColonist(id);
+                        colonists.setStaffingId(i, ColonistPool::kNoStaffingId);
+                    }
+                    if(!fit && colonists.hasJob(i)) {
+                        colonists.setAssigned(i, false);
+                    }
+                    return;
+                }
+                if(id == ColonistPool::kNoStaffingId) {
+                    id = static_cast<std::uint32_t>(jobAssigner.addColonist(colonists.getSpecialization(i),
+                                                                            colonists.getExperience(i)));
+                    colonists.setStaffingId(i, id);
+                } else {
+                    jobAssigner.updateColonist(id, colonists.getSpecialization(i), colonists.getExperience(i));
+                }
+                jobAssigner.placeColonist(id, colonists.getJob(i));
+            });
     }
 
     void initializeGame() {
         loadConfiguration();
         setupEvents();
-        
+        startColony();
+    }
+
+    // Sets up the starting stock, colonists and buildings
+    void startColony() {
+        colonyResources = startingResources;
+
         // Create initial colonists
-        colonists.push_back(std::make_unique<Colonist>("Alex Chen", "Engineer"));
-        colonists.push_back(std::make_unique<Colonist>("Maria Santos", "Scientist"));
-        colonists.push_back(std::make_unique<Colonist>("James Wilson", "Farmer"));
+        colonists.add("Alex Chen", Specialization::Engineer);
+        colonists.add("Maria Santos", Specialization::Scientist);
+        colonists.add("James Wilson", Specialization::Farmer);
         
         gameState.setColonistCount(colonists.size());
 
         // Initial buildings
-        buildings.push_back(std::make_unique<SolarPanel>());
-        buildings.push_back(std::make_unique<Greenhouse>());
+        buildings.add(BuildingType::SolarPanel);
+        buildings.add(BuildingType::Greenhouse);
 
-        std::cout << "Stellar Homestead Colony Established!" << std::endl;
-        std::cout << "Starting resources and colonists initialized." << std::endl;
+        out << "Stellar Homestead Colony Established!" << std::endl;
+        out << "Starting resources and colonists initialized." << std::endl;
     }
 
+    // Compiles the built-in events, then any from the events file (config
+    // key "events", default events.txt). A broken file is reported and
+    // skipped so the game still starts.
     void setupEvents() {
-        events.push_back(std::make_unique<SolarStorm>());
-        events.push_back(std::make_unique<TradeShip>());
-        events.push_back(std::make_unique<MeteorShower>());
+        EventCompiler compiler;
+        std::istringstream builtins(kDefaultEventScript);
+        events = compiler.compile(builtins, "built-in events");
+
+        auto configured = config.find("events");
+        std::string path = configured != config.end() ? configured->second : "events.txt";
+        std::ifstream eventFile(path);
+        if(eventFile) {
+            const std::size_t builtinCount = events.size();
+            try {
+                for(auto& event : compiler.compile(eventFile, path)) {
+                    events.push_back(std::move(event));
+                }
+                linkEvents(events);
+            } catch(const std::exception& e) {
+                out << "Ignoring " << path << ": " << e.what() << std::endl;
+                events.resize(builtinCount);
+            }
+        }
+        linkEvents(events);
+        rebuildEventTable();
+    }
+
+    // Registers an event; each event fires with its own probability (in
+    // percent) and the rest of the 100 is a quiet turn
+    void addEvent(std::unique_ptr<Event> event) {
+        events.push_back(std::move(event));
+        rebuildEventTable();
+    }
+
+    // Weights are the event probabilities plus whatever remains of 100 for
+    // a quiet turn; if they sum past 100 they are used as relative weights
+    void rebuildEventTable() {
+        std::vector<std::uint64_t> weights;
+        std::uint64_t sum = 0;
+        for(const auto& event : events) {
+            std::uint64_t weight = static_cast<std::uint64_t>(std::max(0, event->getProbability()));
+            weights.push_back(weight);
+            sum += weight;
+        }
+        weights.push_back(sum < 100 ? 100 - sum : 0);
+        eventTable.build(weights);
     }
 
+    const TickScheduler& getTicks() const { return ticks; }
+
     void runGameLoop() {
+        ticks.restart();
+        ticks.resetStats();
         while(gameState.isGameRunning()) {
-            displayGameStatus();
+            if(verbose) {
+                displayGameStatus();
+            }
+            GamePhase phase = gameState.getCurrentPhase();
+            std::string phaseName = gameState.getPhaseString();
             
             try {
                 switch(gameState.getCurrentPhase()) {
@@ -554,231 +4372,306 @@ public:
                         break;
                 }
             } catch(const std::exception& e) {
-                std::cout << "Error: " << e.what() << std::endl;
+                out << "Error: " << e.what() << std::endl;
                 handleError();
             }
 
             gameState.nextPhase();
+            if(phase == GamePhase::MANAGEMENT) {
+                endTurn(gameState.getTurn() - 1);
+            }
             
             // Check win/lose conditions
-            checkGameConditions();
+            if(gameState.isGameRunning()) {
+                checkGameConditions();
+            }
+            // Nothing left to pace once the game is over
+            if(!gameState.isGameRunning()) {
+                break;
+            }
             
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            // Time spent waiting on the player is not the phase's budget
+            if(waitedForPlayer) {
+                ticks.restart();
+                waitedForPlayer = false;
+            }
+            auto late = ticks.waitForNextTick();
+            if(late > TickScheduler::Clock::duration::zero() && verbose) {
+                out << "(" << phaseName << " phase ran "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(late).count()
+                    << " ms over its " << ticks.getStep().count() << " ms budget)" << std::endl;
+            }
+        }
+        if(recorder != nullptr) {
+            recorder->end(outcome, static_cast<std::uint32_t>(gameState.getTurn()));
+        }
+        if(ticks.throttled()) {
+            reportOverruns(verbose ? out : std::cerr);
+        }
+    }
+
+    // One-line summary of how many phases ran past their budget. Headless
+    // games silence out, so they report on std::cerr.
+    void reportOverruns(std::ostream& report) const {
+        report << "Phase budget " << ticks.getStep().count() << " ms: " << ticks.overrunCount() << " of "
+               << ticks.tickCount() << " phases ran over";
+        if(ticks.overrunCount() > 0) {
+            report << ", worst by "
+                   << std::chrono::duration<double, std::milli>(ticks.getWorstOverrun()).count() << " ms";
+        }
+        report << std::endl;
+    }
+
+    // Turn-end bookkeeping: observers, the replay log and replay checks
+    void endTurn(int turn) {
+        if(turnObserver != nullptr) {
+            turnObserver->turnEnded(turn, colonyResources, colonists.size());
+        }
+        if(recorder == nullptr && expectedTurns == nullptr) return;
+        std::uint64_t hash = stateHash();
+        if(recorder != nullptr) {
+            recorder->turn(static_cast<std::uint32_t>(turn), hash);
+        }
+        if(expectedTurns != nullptr && checkedTurns < expectedTurns->size()) {
+            const TurnHash& expected = (*expectedTurns)[checkedTurns++];
+            if(expected.turn != static_cast<std::uint32_t>(turn) || expected.hash != hash) {
+                divergence = ReplayDivergence{ true, static_cast<std::uint32_t>(turn), expected.hash, hash };
+                out << "\nReplay diverged at turn " << turn << "." << std::endl;
+                gameState.endGame();
+            }
         }
     }
 
     void handleSetupPhase() {
-        std::cout << "\n=== Setup Phase ===" << std::endl;
-        std::cout << "Colony initialization complete. Press Enter to continue...";
-        std::cin.get();
+        out << "\n=== Setup Phase ===" << std::endl;
+        controller->acknowledge("Colony initialization complete. Press Enter to continue...");
+        waitedForPlayer = controller->interactive();
     }
 
     void handleProductionPhase() {
-        std::cout << "\n=== Production Phase ===" << std::endl;
+        out << "\n=== Production Phase ===" << std::endl;
         
-        Resource totalProduction;
-        
-        // Building production
-        for(auto& building : buildings) {
-            if(building->isOperational()) {
-                Resource buildingOutput = building->produce();
-                totalProduction += buildingOutput;
-                std::cout << building->getProductionInfo() << std::endl;
+        // Building production is maintained incrementally by the store
+#ifdef HOMESTEAD_VERIFY_AGGREGATE
+        if(buildings.getProduction() != buildings.totalProduction()) {
+            verifyFailed("building production aggregate is out of sync");
+        }
+        // Building output is never negative, so a negative lane means a sum
+        // wrapped past the policy
+        for(std::size_t r = 0; r < ResourceRegistry::instance().size(); r++) {
+            if(buildings.getProduction()[static_cast<ResourceId>(r)] < 0) {
+                verifyFailed("building production aggregate overflowed");
             }
         }
+#endif
+        Resource totalProduction = buildings.getProduction();
+        if(productionSink->wantsRecords()) {
+            buildings.reportProduction(*productionSink);
+        }
 
-        // Colonist work
-        for(auto& colonist : colonists) {
-            if(!colonist->isAssigned() && colonist->getHealth() > 50) {
-                Resource colonistOutput = colonist->work();
-                totalProduction += colonistOutput;
-                std::cout << colonist->getName() << " worked and produced resources." << std::endl;
-            }
+        // Colonist work: healthy, unassigned colonists
+        colonists.updateEligible();
+        if(verbose) {
+            colonists.forEachEligible([&](std::size_t i) {
+                out << colonists.getName(i) << " worked and produced resources." << std::endl;
+            });
         }
+        totalProduction += colonists.workEligible(workerPool.get());
+        if(verbose) {
+            colonists.forEachStaffed([&](std::size_t i) {
+                out << colonists.getName(i) << " staffed the " << buildingTypeInfo(colonists.getJob(i)).name
+                    << "." << std::endl;
+            });
+        }
+        totalProduction += colonists.workJobs();
 
         // Apply production to colony resources
         colonyResources += totalProduction;
         
         // Resource consumption per turn
         Resource consumption;
-        consumption["food"] = colonists.size() * 3;
-        consumption["oxygen"] = colonists.size() * 2;
-        consumption["energy"] = buildings.size() * 2;
-        
-        colonyResources -= consumption;
+        consumption[ResourceType::Food] = colonists.size() * 3;
+        consumption[ResourceType::Oxygen] = colonists.size() * 2;
+        consumption[ResourceType::Energy] = buildings.size() * 2;
         
-        std::cout << "Total production applied. Resource consumption deducted." << std::endl;
+        ConsumeResult result = colonyResources.tryConsume(consumption);
+        if(result.satisfied) {
+            out << "Total production applied. Resource consumption deducted." << std::endl;
+        } else {
+            out << "Total production applied. Consumption could not be covered: "
+                << result.describe() << std::endl;
+        }
     }
 
     void handleEventPhase() {
-        std::cout << "\n=== Event Phase ===" << std::endl;
+        out << "\n=== Event Phase ===" << std::endl;
         
-        std::uniform_int_distribution<> eventChance(1, 100);
-        int roll = eventChance(randomGenerator);
-        
-        bool eventTriggered = false;
-        for(auto& event : events) {
-            if(roll <= event->getProbability()) {
-                event->execute(colonyResources, colonists);
-                eventTriggered = true;
-                break;
+        // Scheduled effects due by this turn run first
+        bool scheduledRan = false;
+        eventTimers.advance(static_cast<std::uint64_t>(gameState.getTurn()), [&](const ScheduledEvent& due) {
+            events[due.event]->execute(colonyResources, colonists, &eventTimers, out);
+            scheduledRan = true;
+            if(due.remaining > 1) {
+                eventTimers.insert(eventTimers.currentTurn() + due.interval,
+                                   ScheduledEvent{ due.event, due.remaining - 1, due.interval });
             }
+        });
+
+        RandomStream rolls = randomStream(RngSubsystem::Events);
+        std::size_t picked = eventTable.empty() ? events.size() : eventTable.sample(rolls);
+        if(picked < events.size()) {
+            events[picked]->execute(colonyResources, colonists, &eventTimers, out);
+        } else if(!scheduledRan) {
+            out << "A peaceful turn. No events occurred." << std::endl;
         }
-        
-        if(!eventTriggered) {
-            std::cout << "A peaceful turn. No events occurred." << std::endl;
-        }
+        removeDeadColonists();
+    }
+
+    // Drops everyone who died this phase in a single pass
+    void removeDeadColonists() {
+        colonists.removeDead([this](const std::string& name) {
+            out << name << " has died." << std::endl;
+        });
+        gameState.setColonistCount(colonists.size());
     }
 
     void handleManagementPhase() {
-        std::cout << "\n=== Management Phase ===" << std::endl;
-        std::cout << "1. Build Structure" << std::endl;
-        std::cout << "2. Assign Colonists" << std::endl;
-        std::cout << "3. Rest Colonists" << std::endl;
-        std::cout << "4. Save Game" << std::endl;
-        std::cout << "5. Continue to next turn" << std::endl;
-        std::cout << "Choose action: ";
-        
-        int choice;
-        std::cin >> choice;
-        
-        switch(choice) {
-            case 1:
-                buildStructure();
+        out << "\n=== Management Phase ===" << std::endl;
+        ManagementDecision decision = controller->decide(ColonyView{ gameState.getTurn(), colonyResources,
+                                                                     buildings, colonists });
+        waitedForPlayer = controller->interactive();
+        if(recorder != nullptr) {
+            recorder->decision(decision);
+        }
+        switch(decision.action) {
+            case ManagementAction::Build:
+                buildStructure(decision.building);
                 break;
-            case 2:
-                assignColonists();
+            case ManagementAction::Assign:
+                assignColonist(decision.colonist);
                 break;
-            case 3:
+            case ManagementAction::Rest:
                 restColonists();
                 break;
-            case 4:
-                saveGame();
+            case ManagementAction::Save:
+                // A replay leaves the player's save file alone
+                if(expectedTurns == nullptr) {
+                    saveGame();
+                }
                 break;
-            case 5:
-            default:
-                std::cout << "Continuing to next turn..." << std::endl;
+            case ManagementAction::Staff:
+                staffBuildingsMenu();
+                break;
+            case ManagementAction::Continue:
+                out << "Continuing to next turn..." << std::endl;
                 break;
         }
     }
 
-    void buildStructure() {
-        std::cout << "Available structures:" << std::endl;
-        std::cout << "1. Solar Panel (Materials: 20)" << std::endl;
-        std::cout << "2. Greenhouse (Materials: 30, Energy: 10)" << std::endl;
-        std::cout << "3. Oxygen Generator (Materials: 25, Energy: 15)" << std::endl;
-        std::cout << "4. Material Factory (Materials: 40, Energy: 20)" << std::endl;
-        
-        int choice;
-        std::cin >> choice;
-        
-        std::unique_ptr<Building> newBuilding;
-        
-        switch(choice) {
-            case 1:
-                newBuilding = std::make_unique<SolarPanel>();
-                break;
-            case 2:
-                newBuilding = std::make_unique<Greenhouse>();
-                break;
-            case 3:
-                newBuilding = std::make_unique<OxygenGenerator>();
-                break;
-            case 4:
-                newBuilding = std::make_unique<MaterialFactory>();
-                break;
-            default:
-                std::cout << "Invalid choice." << std::endl;
-                return;
+    void buildStructure(BuildingType type) {
+        if(type >= BuildingType::Count) {
+            out << "Invalid choice." << std::endl;
+            return;
         }
         
-        Resource cost = newBuilding->getCost();
-        if(colonyResources.canAfford(cost)) {
-            colonyResources -= cost;
-            std::cout << "Built " << newBuilding->getName() << "!" << std::endl;
-            buildings.push_back(std::move(newBuilding));
+        const BuildingTypeInfo& info = buildingTypeInfo(type);
+        ConsumeResult result = colonyResources.tryConsume(info.cost);
+        if(result.satisfied) {
+            out << "Built " << info.name << "!" << std::endl;
+            buildings.add(type);
         } else {
-            std::cout << "Insufficient resources to build " << newBuilding->getName() << std::endl;
+            out << "Insufficient resources to build " << info.name
+                << " (" << result.describe() << ")" << std::endl;
         }
     }
 
-    void assignColonists() {
-        std::cout << "Available colonists:" << std::endl;
-        for(size_t i = 0; i < colonists.size(); i++) {
-            std::cout << i + 1 << ". ";
-            colonists[i]->displayInfo();
+    // Assigns a colonist to work; an out-of-range index is a cancelled pick
+    void assignColonist(std::size_t index) {
+        if(index < colonists.size()) {
+            colonists.setAssigned(index, true);
+            out << colonists.getName(index) << " has been assigned to work." << std::endl;
         }
-        
-        std::cout << "Select colonist to assign (0 to cancel): ";
-        size_t choice;
-        std::cin >> choice;
-        
-        if(choice > 0 && choice <= colonists.size()) {
-            colonists[choice - 1]->setAssigned(true);
-            std::cout << colonists[choice - 1]->getName() << " has been assigned to work." << std::endl;
+    }
+
+    void staffBuildingsMenu() {
+        std::int64_t yield = staffBuildings();
+        out << "Jobs assigned for an expected yield of " << yield << " per turn:" << std::endl;
+        for(std::size_t i = 0; i < colonists.size(); i++) {
+            if(colonists.hasJob(i)) {
+                out << "  " << colonists.getName(i) << " -> "
+                    << buildingTypeInfo(colonists.getJob(i)).name << std::endl;
+            }
         }
     }
 
     void restColonists() {
-        for(auto& colonist : colonists) {
-            colonist->rest();
-        }
-        std::cout << "All colonists have rested and recovered health." << std::endl;
+        colonists.restAll();
+        out << "All colonists have rested and recovered health." << std::endl;
     }
 
     void displayGameStatus() {
-        std::cout << "\n" << std::string(50, '=') << std::endl;
-        std::cout << "STELLAR HOMESTEAD - Turn " << gameState.getTurn() << std::endl;
-        std::cout << "Phase: " << gameState.getPhaseString() << std::endl;
-        std::cout << std::string(50, '=') << std::endl;
+        out << "\n" << std::string(50, '=') << std::endl;
+        out << "STELLAR HOMESTEAD - Turn " << gameState.getTurn() << std::endl;
+        out << "Phase: " << gameState.getPhaseString() << std::endl;
+        out << std::string(50, '=') << std::endl;
         
-        colonyResources.display();
+        colonyResources.display(out);
         
-        std::cout << "Buildings (" << buildings.size() << "):" << std::endl;
-        for(const auto& building : buildings) {
-            std::cout << "  " << building->getName() << " Level " << building->getLevel()
-                      << " (" << (building->isOperational() ? "Operational" : "Offline") << ")" << std::endl;
+        out << "Buildings (" << buildings.size() << "):" << std::endl;
+        for(std::size_t i = 0; i < buildings.size(); i++) {
+            BuildingView building = buildings.view(i);
+            out << "  " << building.getName() << " Level " << building.getLevel()
+                << " (" << (building.isOperational() ? "Operational" : "Offline") << ")" << std::endl;
         }
         
-        std::cout << "Colonists (" << colonists.size() << "):" << std::endl;
-        for(const auto& colonist : colonists) {
-            std::cout << "  ";
-            colonist->displayInfo();
+        out << "Colonists (" << colonists.size() << "):" << std::endl;
+        for(std::size_t i = 0; i < colonists.size(); i++) {
+            out << "  ";
+            colonists.displayInfo(i, out);
         }
     }
 
     void checkGameConditions() {
         // Win condition: 10 turns survived with healthy colony
         if(gameState.getTurn() >= 10 && colonists.size() >= 3) {
-            std::cout << "\nCongratulations! Your colony has thrived for 10 turns!" << std::endl;
+            out << "\nCongratulations! Your colony has thrived for 10 turns!" << std::endl;
+            outcome = GameOutcome::Won;
             gameState.endGame();
             return;
         }
         
         // Lose conditions
-        if(colonyResources["food"] <= 0 || colonyResources["oxygen"] <= 0) {
-            std::cout << "\nGame Over! Your colony has run out of essential resources." << std::endl;
+        if(colonyResources[ResourceType::Food] <= 0 || colonyResources[ResourceType::Oxygen] <= 0) {
+            out << "\nGame Over! Your colony has run out of essential resources." << std::endl;
+            outcome = GameOutcome::OutOfResources;
             gameState.endGame();
             return;
         }
         
         if(colonists.empty()) {
-            std::cout << "\nGame Over! All colonists have perished." << std::endl;
+            out << "\nGame Over! All colonists have perished." << std::endl;
+            outcome = GameOutcome::AllPerished;
             gameState.endGame();
             return;
         }
+
+        if(maxTurns != 0 && gameState.getTurn() > maxTurns) {
+            out << "\nThe simulation reached its turn limit." << std::endl;
+            outcome = GameOutcome::TurnLimit;
+            gameState.endGame();
+        }
     }
 
     void handleError() {
-        std::cout << "An error occurred. Attempting to continue..." << std::endl;
+        out << "An error occurred. Attempting to continue..." << std::endl;
         // Error recovery logic here
     }
 
     void handleEndGame() {
-        std::cout << "\nGame ended after " << gameState.getTurn() << " turns." << std::endl;
-        std::cout << "Final colony status:" << std::endl;
-        colonyResources.display();
-        std::cout << "Thank you for playing Stellar Homestead!" << std::endl;
+        out << "\nGame ended after " << gameState.getTurn() << " turns." << std::endl;
+        out << "Final colony status:" << std::endl;
+        colonyResources.display(out);
+        out << "Thank you for playing Stellar Homestead!" << std::endl;
     }
 
     // File I/O for game save/load
@@ -793,22 +4686,69 @@ public:
             colonyResources.saveToFile(file);
             
             // Save buildings
-            file << buildings.size() << std::endl;
-            for(const auto& building : buildings) {
-                building->saveToFile(file);
-            }
+            buildings.saveToFile(file);
             
             // Save colonists
-            file << colonists.size() << std::endl;
-            for(const auto& colonist : colonists) {
-                colonist->saveToFile(file);
-            }
+            colonists.saveToFile(file);
+            
+            // Save scheduled events
+            saveTimers(file);
             
             file.close();
-            std::cout << "Game saved successfully!" << std::endl;
+            out << "Game saved successfully!" << std::endl;
             
         } catch(const std::exception& e) {
-            std::cout << "Failed to save game: " << e.what() << std::endl;
+            out << "Failed to save game: " << e.what() << std::endl;
+        }
+    }
+
+    // Pending timers are saved by event name, not by index into the event
+    // list, so a save still loads after events.txt is reordered. One line
+    // per timer: due turn, runs left, interval, then the name, which may
+    // contain spaces.
+    void saveTimers(std::ofstream& file) const {
+        file << eventTimers.currentTurn() << " " << eventTimers.size() << std::endl;
+        eventTimers.forEachPending([&](std::uint64_t due, const ScheduledEvent& scheduled) {
+            file << due << " " << scheduled.remaining << " " << scheduled.interval << " "
+                 << events[scheduled.event]->getName() << std::endl;
+        });
+    }
+
+    // Throws GameStateException on a truncated record or an event name the
+    // loaded events do not define; the current timers are kept in that case
+    void loadTimers(std::ifstream& file) {
+        std::uint64_t turn;
+        std::size_t count;
+        file >> turn >> count;
+        if(file.fail()) {
+            throw GameStateException("Missing scheduled events in save file");
+        }
+        // The timers never run ahead of the game turn loaded before them
+        if(turn > static_cast<std::uint64_t>(gameState.getTurn())) {
+            throw GameStateException("Scheduled events are ahead of the saved turn");
+        }
+        std::vector<std::pair<std::uint64_t, ScheduledEvent>> pending;
+        for(std::size_t i = 0; i < count; i++) {
+            std::uint64_t due;
+            ScheduledEvent scheduled;
+            std::string name;
+            file >> due >> scheduled.remaining >> scheduled.interval;
+            std::getline(file >> std::ws, name);
+            if(file.fail() || due <= turn || scheduled.remaining == 0) {
+                throw GameStateException("Bad scheduled event in save file");
+            }
+            auto found = std::find_if(events.begin(), events.end(),
+                                      [&](const std::unique_ptr<Event>& event) { return event->getName() == name; });
+            if(found == events.end()) {
+                throw GameStateException("Unknown scheduled event in save file: " + name);
+            }
+            scheduled.event = static_cast<std::uint32_t>(found - events.begin());
+            pending.emplace_back(due, scheduled);
+        }
+        eventTimers.clear();
+        eventTimers.advance(turn, [](const ScheduledEvent&) {});
+        for(const auto& entry : pending) {
+            eventTimers.insert(entry.first, entry.second);
         }
     }
 
@@ -823,27 +4763,31 @@ public:
             colonyResources.loadFromFile(file);
             
             // Load buildings
-            int buildingCount;
-            file >> buildingCount;
-            buildings.clear();
-            // Note: In a full implementation, you'd need a factory pattern
-            // to recreate the correct building types from saved data
+            buildings.loadFromFile(file);
+            
+            // Load colonists; the job solver picks their staffing up from
+            // scratch at the next staffing
+            colonists.loadFromFile(file);
+            jobAssigner.clear();
             
-            // Load colonists
-            int colonistCount;
-            file >> colonistCount;
-            colonists.clear();
-            // Similar factory pattern needed for colonists
+            // Load scheduled events
+            loadTimers(file);
             
             file.close();
-            std::cout << "Game loaded successfully!" << std::endl;
+            out << "Game loaded successfully!" << std::endl;
             
         } catch(const std::exception& e) {
-            std::cout << "Failed to load game: " << e.what() << std::endl;
+            out << "Failed to load game: " << e.what() << std::endl;
         }
     }
 
+    // A malformed value falls back to the default configuration; declaring
+    // more resource types than the registry holds is a config error that
+    // stops the game from starting. Either way nothing is registered unless
+    // the whole file checks out.
     void loadConfiguration() {
+        std::vector<std::pair<std::string, long long>> extraResources;
+        std::size_t newTypes = 0;
         try {
             std::ifstream configFile("config.txt");
             std::string key, value;
@@ -854,31 +4798,179 @@ public:
             
             configFile.close();
             
-            // Apply configuration settings
-            if(config.find("difficulty") != config.end()) {
-                std::cout << "Difficulty set to: " << config["difficulty"] << std::endl;
+            // "resource.<name> <amount>" registers an extra resource type
+            // with the given starting stock
+            const std::string resourcePrefix = "resource.";
+            for(const auto& entry : config) {
+                if(entry.first.compare(0, resourcePrefix.size(), resourcePrefix) == 0) {
+                    std::string name = entry.first.substr(resourcePrefix.size());
+                    ResourceId known;
+                    if(!ResourceRegistry::instance().find(name, known)) {
+                        newTypes++;
+                    }
+                    extraResources.emplace_back(name, std::stoll(entry.second));
+                }
             }
-            
         } catch(const std::exception& e) {
-            std::cout << "Using default configuration." << std::endl;
+            out << "Using default configuration." << std::endl;
             // Set default config values
             config["difficulty"] = "normal";
             config["auto_save"] = "true";
+            return;
+        }
+
+        if(ResourceRegistry::instance().size() + newTypes > kMaxResourceTypes) {
+            throw GameStateException("config.txt declares " + std::to_string(newTypes) + " new resource types but only " +
+                                     std::to_string(kMaxResourceTypes - ResourceRegistry::instance().size()) +
+                                     " more fit (at most " + std::to_string(kMaxResourceTypes) + " in total)");
+        }
+
+        // Apply configuration settings
+        for(const auto& resource : extraResources) {
+            ResourceId id = ResourceRegistry::instance().intern(resource.first);
+            startingResources[id] = resource.second;
+        }
+
+        if(config.find("difficulty") != config.end()) {
+            out << "Difficulty set to: " << config["difficulty"] << std::endl;
+        }
+    }
+};
+
+// Tally of a headless batch
+struct HeadlessSummary {
+    std::uint64_t seed = 0;
+    std::size_t games = 0;
+    std::array<std::size_t, 5> outcomes{};     // indexed by GameOutcome
+    std::uint64_t totalTurns = 0;
+
+    std::size_t count(GameOutcome outcome) const { return outcomes[static_cast<std::size_t>(outcome)]; }
+};
+
+// Plays options.games games back to back on one engine. All share one seed
+// and game i is colony options.colony + i, so any single game can be
+// replayed with --seed and --colony.
+HeadlessSummary runHeadlessGames(const GameOptions& options) {
+    HeadlessSummary summary;
+    summary.seed = options.seed != 0 ? options.seed : std::random_device{}() | 1;
+    GameOptions firstGame = options;
+    firstGame.seed = summary.seed;
+    GameEngine game(firstGame);     // set up for game 0, which --record logs
+    for(std::size_t i = 0; i < options.games; i++) {
+        if(i > 0) {
+            game.reset(summary.seed, static_cast<std::uint32_t>(options.colony + i));
         }
+        game.runGameLoop();
+        summary.outcomes[static_cast<std::size_t>(game.getOutcome())]++;
+        summary.totalTurns += static_cast<std::uint64_t>(game.getTurn());
+        summary.games++;
+    }
+    return summary;
+}
+
+// Result of replaying a log
+struct ReplayReport {
+    ReplayDivergence divergence;
+    std::size_t decisionsUsed = 0;
+    GameOutcome outcome = GameOutcome::Running;
+    int finalTurn = 0;
+    std::size_t repeats = 0;
+    double seconds = 0;
+
+    // The game ended as recorded with every turn matching
+    bool matches(const ReplayLog& log) const {
+        return !divergence.found && (!log.finished || (outcome == log.outcome
+                                                      && finalTurn == static_cast<int>(log.finalTurn)));
     }
 };
 
+// Replays a log headlessly with no pauses, repeats times on one engine,
+// checking each turn's state hash. Stops at the first divergent run.
+ReplayReport replayLog(const ReplayLog& log, std::size_t repeats) {
+    GameOptions options;
+    options.headless = true;
+    options.phaseMillis = 0;
+    options.rng = log.rng;
+    options.seed = log.seed;
+    options.colony = log.colony;
+    options.maxTurns = static_cast<int>(log.maxTurns);
+    GameEngine game(options);
+    auto controller = std::make_unique<ReplayController>(log.decisions);
+    ReplayController& playback = *controller;
+    game.setController(std::move(controller));
+
+    ReplayReport report;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t run = 0; run < repeats; run++) {
+        game.reset(log.seed, log.colony);
+        game.verifyTurns(&log.turns);
+        game.runGameLoop();
+        report.repeats++;
+        report.divergence = game.getDivergence();
+        report.decisionsUsed = playback.used();
+        report.outcome = game.getOutcome();
+        report.finalTurn = game.getTurn();
+        if(!report.matches(log)) break;
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
 // Main function
-int main() {
+#ifndef HOMESTEAD_NO_MAIN
+int main(int argc, char* argv[]) {
     try {
+        GameOptions options = parseGameOptions(argc, argv);
+
+        if(!options.replayPath.empty()) {
+            ReplayLog log = ReplayLog::load(options.replayPath);
+            ReplayReport report = replayLog(log, options.games);
+            std::cout << "Replayed " << options.replayPath << " (seed " << log.seed << ", colony " << log.colony
+                      << "): " << report.finalTurn << " turns, " << report.decisionsUsed << " of "
+                      << log.decisions.size() << " choices" << std::endl;
+            if(report.divergence.found) {
+                std::cout << "First divergence at turn " << report.divergence.turn << ": expected state hash "
+                          << std::hex << report.divergence.expected << ", got " << report.divergence.actual
+                          << std::dec << std::endl;
+            } else {
+                std::cout << "State hashes match for all " << log.turns.size() << " recorded turns" << std::endl;
+            }
+            if(log.finished) {
+                std::cout << "Outcome " << gameOutcomeName(report.outcome) << " on turn " << report.finalTurn
+                          << " (recorded: " << gameOutcomeName(log.outcome) << " on turn " << log.finalTurn << ")"
+                          << std::endl;
+            } else {
+                std::cout << "The recorded session was interrupted; outcome not compared" << std::endl;
+            }
+            std::cout << report.repeats << " replays in " << report.seconds * 1000.0 << " ms ("
+                      << double(report.repeats) * report.finalTurn / std::max(report.seconds, 1e-9)
+                      << " turns per second)" << std::endl;
+            return report.matches(log) ? 0 : 1;
+        }
+
+        if(options.headless) {
+            auto start = std::chrono::steady_clock::now();
+            HeadlessSummary summary = runHeadlessGames(options);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << summary.games << " games with the " << options.policy << " policy, seed "
+                      << summary.seed << ", colonies " << options.colony << ".."
+                      << options.colony + summary.games - 1 << std::endl;
+            std::cout << "  won:               " << summary.count(GameOutcome::Won) << std::endl;
+            std::cout << "  out of resources:  " << summary.count(GameOutcome::OutOfResources) << std::endl;
+            std::cout << "  all perished:      " << summary.count(GameOutcome::AllPerished) << std::endl;
+            std::cout << "  turn limit:        " << summary.count(GameOutcome::TurnLimit) << std::endl;
+            std::cout << "  average turns:     " << double(summary.totalTurns) / double(summary.games) << std::endl;
+            std::cout << "  games per second:  " << double(summary.games) / std::max(seconds, 1e-9) << std::endl;
+            return 0;
+        }
+
         std::cout << "Welcome to Stellar Homestead!" << std::endl;
         std::cout << "A space colony management simulation." << std::endl;
         std::cout << "Manage resources, build structures, and keep your colonists alive!" << std::endl;
         
-        GameEngine game;
+        GameEngine game(options);
         
-        std::cout << "\nPress Enter to start the game...";
-        std::cin.get();
+        game.waitForPlayer("\nPress Enter to start the game...");
         
         game.runGameLoop();
         
@@ -888,4 +4980,5 @@ int main() {
     }
     
     return 0;
-}
\ No newline at end of file
+}
+#endif
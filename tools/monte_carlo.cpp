@@ -0,0 +1,208 @@
+// Monte Carlo runner: plays many independent headless games across all cores
+// and reports how colonies fare. All games share one seed and game i is
+// colony i, so any game can be replayed alone with
+// `homestead --headless --seed S --colony i`.
+//
+// Each worker owns one engine, reset between games, and a range of colony
+// numbers. A worker that runs dry steals the upper half of another worker's
+// remaining range, so a few long games do not leave the other cores idle.
+// Totals are integer sums, so the report does not depend on the thread
+// count.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o monte_carlo tools/monte_carlo.cpp
+// Run:   ./monte_carlo [games] [threads] [policy] [seed]
+//        (default: 1000000, hardware threads, greedy, 1)
+#define HOMESTEAD_NO_MAIN
+#include "../homestead.cpp"
+
+#include <cstdlib>
+#include <iomanip>
+
+// Colonies [begin, end) still to be played by one worker
+class ColonyRange {
+private:
+    std::mutex mutex;
+    std::uint64_t begin = 0;
+    std::uint64_t end = 0;
+
+public:
+    void assign(std::uint64_t first, std::uint64_t last) {
+        std::lock_guard<std::mutex> lock(mutex);
+        begin = first;
+        end = last;
+    }
+
+    // Owner side: takes the lowest remaining colony
+    bool pop(std::uint64_t& colony) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(begin == end) return false;
+        colony = begin++;
+        return true;
+    }
+
+    // Thief side: takes the upper half, or the last colony
+    bool stealHalf(std::uint64_t& first, std::uint64_t& last) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(begin == end) return false;
+        std::uint64_t middle = begin + (end - begin) / 2;
+        first = middle;
+        last = end;
+        end = middle;
+        return true;
+    }
+};
+
+// Sums over every game that completed a given turn
+struct TurnTotals {
+    std::uint64_t games = 0;
+    std::array<std::int64_t, kBuiltinResourceCount> stock{};
+    std::uint64_t colonists = 0;
+};
+
+struct BatchTotals {
+    std::array<std::uint64_t, 5> outcomes{};       // indexed by GameOutcome
+    std::uint64_t turns = 0;
+    std::vector<TurnTotals> byTurn;                 // index 0 is turn 1
+
+    void merge(const BatchTotals& other) {
+        for(std::size_t i = 0; i < outcomes.size(); i++) outcomes[i] += other.outcomes[i];
+        turns += other.turns;
+        if(byTurn.size() < other.byTurn.size()) byTurn.resize(other.byTurn.size());
+        for(std::size_t t = 0; t < other.byTurn.size(); t++) {
+            byTurn[t].games += other.byTurn[t].games;
+            for(std::size_t r = 0; r < kBuiltinResourceCount; r++) byTurn[t].stock[r] += other.byTurn[t].stock[r];
+            byTurn[t].colonists += other.byTurn[t].colonists;
+        }
+    }
+};
+
+class Worker : public TurnObserver {
+public:
+    BatchTotals totals;
+
+    explicit Worker(const GameOptions& options) : engine(options) {
+        engine.setTurnObserver(this);
+    }
+
+    void turnEnded(int turn, const Resource& resources, std::size_t colonistCount) override {
+        std::size_t index = static_cast<std::size_t>(turn - 1);
+        if(index >= totals.byTurn.size()) totals.byTurn.resize(index + 1);
+        TurnTotals& row = totals.byTurn[index];
+        row.games++;
+        for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+            row.stock[r] += resources[static_cast<ResourceId>(r)];
+        }
+        row.colonists += colonistCount;
+    }
+
+    void play(std::uint64_t seed, std::uint64_t colony) {
+        engine.reset(seed, static_cast<std::uint32_t>(colony));
+        engine.runGameLoop();
+        totals.outcomes[static_cast<std::size_t>(engine.getOutcome())]++;
+        totals.turns += static_cast<std::uint64_t>(engine.getTurn());
+    }
+
+private:
+    GameEngine engine;
+};
+
+static void runWorker(std::size_t self, std::uint64_t seed, std::vector<std::unique_ptr<Worker>>& workers,
+                      std::vector<ColonyRange>& ranges) {
+    std::uint64_t colony;
+    for(;;) {
+        while(ranges[self].pop(colony)) {
+            workers[self]->play(seed, colony);
+        }
+        // Look for a victim, starting with the next worker over
+        bool stole = false;
+        for(std::size_t k = 1; k < ranges.size() && !stole; k++) {
+            std::uint64_t first, last;
+            if(ranges[(self + k) % ranges.size()].stealHalf(first, last)) {
+                ranges[self].assign(first, last);
+                stole = true;
+            }
+        }
+        // Work only ever moves between ranges, so one empty sweep means
+        // every colony has been claimed
+        if(!stole) return;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t games = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                   : std::max(1u, std::thread::hardware_concurrency());
+    GameOptions options;
+    options.headless = true;
+    options.policy = argc > 3 ? argv[3] : "greedy";
+    options.maxTurns = kHeadlessTurnLimit;
+    options.phaseMillis = 0;
+    std::uint64_t seed = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+    if(games == 0 || threads == 0 || seed == 0) {
+        std::cerr << "games, threads and seed must be positive" << std::endl;
+        return 1;
+    }
+    if(games > 0x100000000ull) {
+        std::cerr << "at most 2^32 games (one per colony number)" << std::endl;
+        return 1;
+    }
+    threads = static_cast<std::size_t>(std::min<std::uint64_t>(threads, games));
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<ColonyRange> ranges(threads);
+    try {
+        // Engines are built here, one at a time: loading config.txt may
+        // register resource names
+        for(std::size_t w = 0; w < threads; w++) {
+            workers.push_back(std::make_unique<Worker>(options));
+            ranges[w].assign(games * w / threads, games * (w + 1) / threads);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for(std::size_t w = 1; w < threads; w++) {
+        pool.emplace_back(runWorker, w, seed, std::ref(workers), std::ref(ranges));
+    }
+    runWorker(0, seed, workers, ranges);
+    for(auto& thread : pool) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BatchTotals totals;
+    for(const auto& worker : workers) totals.merge(worker->totals);
+
+    auto percent = [&](std::uint64_t count) { return 100.0 * double(count) / double(games); };
+    auto outcome = [&](GameOutcome o) { return totals.outcomes[static_cast<std::size_t>(o)]; };
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << games << " games, " << options.policy << " policy, seed " << seed << ", colonies 0.."
+              << games - 1 << ", " << threads << " threads" << std::endl;
+    std::cout << "  survived:          " << percent(outcome(GameOutcome::Won) + outcome(GameOutcome::TurnLimit))
+              << "%" << std::endl;
+    std::cout << "  won:               " << percent(outcome(GameOutcome::Won)) << "%" << std::endl;
+    std::cout << "  out of resources:  " << percent(outcome(GameOutcome::OutOfResources)) << "%" << std::endl;
+    std::cout << "  all perished:      " << percent(outcome(GameOutcome::AllPerished)) << "%" << std::endl;
+    std::cout << "  turn limit:        " << percent(outcome(GameOutcome::TurnLimit)) << "%" << std::endl;
+    std::cout << "  average turns:     " << double(totals.turns) / double(games) << std::endl;
+    std::cout << "  games per second:  " << double(games) / std::max(seconds, 1e-9) << std::endl;
+
+    // Mean stock at the end of each turn over the games still running then
+    std::cout << "\nturn  running%";
+    for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+        std::cout << std::setw(11) << ResourceRegistry::instance().name(static_cast<ResourceId>(r));
+    }
+    std::cout << "  colonists" << std::endl;
+    std::size_t stride = (totals.byTurn.size() + 39) / 40;
+    for(std::size_t t = 0; t < totals.byTurn.size(); t += std::max<std::size_t>(stride, 1)) {
+        const TurnTotals& row = totals.byTurn[t];
+        if(row.games == 0) continue;
+        std::cout << std::setw(4) << t + 1 << std::setw(10) << percent(row.games);
+        for(std::size_t r = 0; r < kBuiltinResourceCount; r++) {
+            std::cout << std::setw(11) << double(row.stock[r]) / double(row.games);
+        }
+        std::cout << std::setw(11) << double(row.colonists) / double(row.games) << std::endl;
+    }
+    return 0;
+}